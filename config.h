@@ -53,17 +53,28 @@
 #define UTIL_WEIGHT .60
 
 /* 
- * Alignment requirement in bytes (either 4 or 8) 
+ * Alignment requirement in bytes (8, 16, 32 or 64). Build with
+ * "make ALIGNMENT=n" to change it for the allocator and the driver.
  */
+#ifndef ALIGNMENT
+#ifdef MM_ALIGNMENT
+#define ALIGNMENT MM_ALIGNMENT
+#else
 #define ALIGNMENT 8  
+#endif
+#endif
 
 /* 
  * Maximum heap size in bytes 
  */
+#ifndef MAX_HEAP
 #define MAX_HEAP (20*(1<<20))  /* 20 MB */
+#endif
 
 /*****************************************************************************
- * Set exactly one of these USE_xxx constants to "1" to select a timing method
+ * Set exactly one of these USE_xxx constants to "1" to select the default
+ * timing method; "mdriver -k" picks one at run time, including the mono
+ * and tsc timers, which have no constant here
  *****************************************************************************/
 #define USE_FCYC   0   /* cycle counter w/K-best scheme (x86 & Alpha only) */
 #define USE_ITIMER 0   /* interval timer (any Unix box) */
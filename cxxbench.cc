@@ -0,0 +1,212 @@
+/*
+ * cxxbench.cc - std::vector, std::unordered_map and std::string heavy
+ *     workloads, run with the default std::allocator, with a
+ *     std::pmr::polymorphic_allocator over an mm_memory_resource, and
+ *     with mm_allocator.
+ *
+ * "make cxxbench" links the default operator new and delete, and
+ * "make cxxbench-mm" links mm_new.cc, so that the std::allocator
+ * column there measures mm through the global operator new.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <memory_resource>
+#include <unistd.h>
+
+#include "mm_cxx.h"
+
+#define DEF_SCALE  1          /* default workload multiplier */
+#define HEAP_SIZE  (512<<20)  /* heap behind the mm resource */
+#define REPS       3          /* best of REPS runs */
+
+/* Container types for an allocator of char */
+template <class A, class T>
+using rebind_t = typename std::allocator_traits<A>::template rebind_alloc<T>;
+
+template <class A>
+using str_t = std::basic_string<char, std::char_traits<char>, A>;
+
+struct str_hash {
+    template <class S>
+    std::size_t operator()(const S &s) const
+    {
+        return std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+    }
+};
+
+/*
+ * bench_vectors - grow many int vectors by push_back and drop them
+ */
+template <class A>
+static long bench_vectors(const A &alloc, int scale)
+{
+    typedef std::vector<int, rebind_t<A, int> > vec_t;
+    long sum = 0;
+
+    for (int r = 0; r < 20 * scale; r++) {
+        std::vector<vec_t, rebind_t<A, vec_t> > vecs(alloc);
+
+        for (int i = 0; i < 1000; i++) {
+            vecs.push_back(vec_t(alloc));
+            for (int j = 0; j < (i * 7919) % 200; j++)
+                vecs.back().push_back(j);
+        }
+        for (auto &v : vecs)
+            sum += v.size();
+    }
+    return sum;
+}
+
+/*
+ * bench_map - insert, look up and erase string keys in a hash map
+ */
+template <class A>
+static long bench_map(const A &alloc, int scale)
+{
+    typedef str_t<rebind_t<A, char> > key_t;
+    typedef std::unordered_map<key_t, int, str_hash, std::equal_to<key_t>,
+                               rebind_t<A, std::pair<const key_t, int> > > map_t;
+    long sum = 0;
+
+    for (int r = 0; r < 2 * scale; r++) {
+        map_t map(16, str_hash(), std::equal_to<key_t>(), alloc);
+        char buf[32];
+
+        for (int i = 0; i < 50000; i++) {
+            snprintf(buf, sizeof(buf), "session-key-%08d", i);
+            map.emplace(key_t(buf, alloc), i);
+        }
+        for (int i = 0; i < 50000; i += 3) {
+            snprintf(buf, sizeof(buf), "session-key-%08d", i);
+            auto it = map.find(key_t(buf, alloc));
+            if (it != map.end())
+                sum += it->second;
+        }
+        for (int i = 0; i < 50000; i += 2) {
+            snprintf(buf, sizeof(buf), "session-key-%08d", i);
+            map.erase(key_t(buf, alloc));
+        }
+        sum += map.size();
+    }
+    return sum;
+}
+
+/*
+ * bench_strings - build strings piece by piece, sort and join them
+ */
+template <class A>
+static long bench_strings(const A &alloc, int scale)
+{
+    typedef str_t<rebind_t<A, char> > s_t;
+    long sum = 0;
+
+    for (int r = 0; r < 4 * scale; r++) {
+        std::vector<s_t, rebind_t<A, s_t> > strs(alloc);
+
+        for (int i = 0; i < 20000; i++) {
+            s_t s(alloc);
+            for (int j = 0; j < 1 + i % 9; j++) {
+                s += "field";
+                s += std::to_string((i * 31 + j) % 1000);
+                s += ';';
+            }
+            strs.push_back(std::move(s));
+        }
+        std::sort(strs.begin(), strs.end());
+
+        s_t all(alloc);
+        for (auto &s : strs)
+            all += s;
+        sum += all.size();
+    }
+    return sum;
+}
+
+/*
+ * best_ms - best of REPS runs of f, in milliseconds
+ */
+template <class F>
+static double best_ms(F f, long *check)
+{
+    double best = 1e30;
+
+    for (int i = 0; i < REPS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        *check = f();
+        std::chrono::duration<double, std::milli> d =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, d.count());
+    }
+    return best;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: cxxbench [-h] [-s <scale>]\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h          Print this message.\n");
+    fprintf(stderr, "\t-s <scale>  Workload multiplier (default %d).\n", DEF_SCALE);
+}
+
+int main(int argc, char **argv)
+{
+    int scale = DEF_SCALE;
+    int c;
+
+    while ((c = getopt(argc, argv, "hs:")) != EOF) {
+        switch (c) {
+        case 's':
+            scale = atoi(optarg);
+            break;
+        case 'h':
+            usage();
+            exit(0);
+        default:
+            usage();
+            exit(1);
+        }
+    }
+    if (scale <= 0) {
+        usage();
+        exit(1);
+    }
+
+    mm_memory_resource resource(HEAP_SIZE);
+    std::allocator<char> std_alloc;
+    std::pmr::polymorphic_allocator<char> pmr_alloc(&resource);
+    mm_allocator<char> mm_alloc(resource.heap());
+
+#ifdef MM_GLOBAL_NEW
+    const char *std_name = "new->mm";
+#else
+    const char *std_name = "new";
+#endif
+
+    printf("%-10s%12s%12s%12s   (ms, best of %d)\n",
+           "workload", std_name, "pmr mm", "mm_alloc", REPS);
+
+#define ROW(name, fn) \
+    do { \
+        long a, b, m; \
+        double ta = best_ms([&] { return fn(std_alloc, scale); }, &a); \
+        double tb = best_ms([&] { return fn(pmr_alloc, scale); }, &b); \
+        double tm = best_ms([&] { return fn(mm_alloc, scale); }, &m); \
+        if (a != b || a != m) { \
+            fprintf(stderr, "cxxbench: %s results differ\n", name); \
+            exit(1); \
+        } \
+        printf("%-10s%12.1f%12.1f%12.1f\n", name, ta, tb, tm); \
+    } while (0)
+
+    ROW("vectors", bench_vectors);
+    ROW("map", bench_map);
+    ROW("strings", bench_strings);
+
+    return 0;
+}
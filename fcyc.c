@@ -30,6 +30,7 @@ static int compensate = COMPENSATE;
 static int clear_cache = CLEAR_CACHE;
 static int cache_bytes = CACHE_BYTES;
 static int cache_block = CACHE_BLOCK;
+static double (*clock_now)(void) = NULL;
 
 static int *cache_buf = NULL;
 
@@ -130,7 +131,16 @@ double fcyc(test_funct f, void *argp)
 {
     double result;
     init_sampler();
-    if (compensate) {
+    if (clock_now) {
+	do {
+	    double t;
+	    if (clear_cache)
+		clear();
+	    t = clock_now();
+	    f(argp);
+	    add_sample(clock_now() - t);
+	} while (!has_converged() && samplecount < maxsamples);
+    } else if (compensate) {
 	do {
 	    double cyc;
 	    if (clear_cache)
@@ -245,6 +255,17 @@ void set_fcyc_epsilon(double epsilon_arg)
     epsilon = epsilon_arg;
 }
 
+/* 
+ * set_fcyc_clock - When not NULL, samples are differences of now()
+ *     instead of readings of the clock.c cycle counter, and
+ *     set_fcyc_compensate() has no effect
+ *     Default = NULL
+ */
+void set_fcyc_clock(double (*now)(void))
+{
+    clock_now = now;
+}
+
 
 
 
@@ -63,6 +63,14 @@ void set_fcyc_maxsamples(int maxsamples_arg);
  */
 void set_fcyc_epsilon(double epsilon_arg);
 
+/* 
+ * set_fcyc_clock - When not NULL, samples are differences of now()
+ *     instead of readings of the clock.c cycle counter, and
+ *     set_fcyc_compensate() has no effect
+ *     Default = NULL
+ */
+void set_fcyc_clock(double (*now)(void));
+
 
 
 
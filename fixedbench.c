@@ -0,0 +1,145 @@
+/*
+ * fixedbench.c - measure what the compile-time fast path saves:
+ *     mm_malloc_fixed() with a constant size against mm_malloc() with
+ *     the same size passed at run time.
+ *
+ * Each round allocates a batch of objects and frees them in LIFO
+ * order. Results are cycles per alloc+free pair, measured with fcyc.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "fcyc.h"
+
+#define DEF_BATCH  1000   /* default objects per round */
+#define DEF_ROUNDS 100    /* default rounds per measurement */
+#define MAX_BATCH  10000  /* objects must fit in the simulated heap */
+
+/* Parameters for the timed functions */
+typedef struct {
+    size_t size;       /* object size, for the run-time path */
+    int batch;         /* objects per round */
+    int rounds;        /* rounds per call */
+    void **objs;
+} bench_t;
+
+/*
+ * BENCH - define bench_var_<size>, which passes size to mm_malloc at
+ *     run time, and bench_fixed_<size>, which uses the constant fast path
+ */
+#define BENCH(SIZE) \
+static void bench_var_##SIZE(void *argp) \
+{ \
+    bench_t *b = (bench_t *)argp; \
+    int r, i; \
+ \
+    for (r = 0; r < b->rounds; r++) { \
+	for (i = 0; i < b->batch; i++) \
+	    b->objs[i] = mm_malloc(b->size); \
+	for (i = b->batch - 1; i >= 0; i--) \
+	    mm_free(b->objs[i]); \
+    } \
+} \
+ \
+static void bench_fixed_##SIZE(void *argp) \
+{ \
+    bench_t *b = (bench_t *)argp; \
+    int r, i; \
+ \
+    for (r = 0; r < b->rounds; r++) { \
+	for (i = 0; i < b->batch; i++) \
+	    b->objs[i] = mm_malloc_fixed(SIZE); \
+	for (i = b->batch - 1; i >= 0; i--) \
+	    mm_free(b->objs[i]); \
+    } \
+}
+
+BENCH(8)
+BENCH(24)
+BENCH(48)
+BENCH(120)
+BENCH(500)
+BENCH(2000)
+
+static struct {
+    size_t size;
+    test_funct var;
+    test_funct fixed;
+} benches[] = {
+    {8, bench_var_8, bench_fixed_8},
+    {24, bench_var_24, bench_fixed_24},
+    {48, bench_var_48, bench_fixed_48},
+    {120, bench_var_120, bench_fixed_120},
+    {500, bench_var_500, bench_fixed_500},
+    {2000, bench_var_2000, bench_fixed_2000},
+};
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: fixedbench [-h] [-n <batch>] [-r <rounds>]\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h          Print this message.\n");
+    fprintf(stderr, "\t-n <batch>  Objects allocated per round (default %d).\n", DEF_BATCH);
+    fprintf(stderr, "\t-r <rounds> Rounds per measurement (default %d).\n", DEF_ROUNDS);
+}
+
+int main(int argc, char **argv)
+{
+    bench_t b;
+    char c;
+    int i;
+    double var_cycles, fixed_cycles, pairs;
+
+    b.batch = DEF_BATCH;
+    b.rounds = DEF_ROUNDS;
+
+    while ((c = getopt(argc, argv, "hn:r:")) != EOF) {
+	switch (c) {
+	case 'n':
+	    b.batch = atoi(optarg);
+	    break;
+	case 'r':
+	    b.rounds = atoi(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (b.batch <= 0 || b.batch > MAX_BATCH || b.rounds <= 0) {
+	usage();
+	exit(1);
+    }
+
+    if ((b.objs = malloc(b.batch * sizeof(void *))) == NULL) {
+	fprintf(stderr, "fixedbench: malloc failed\n");
+	exit(1);
+    }
+
+    mem_init();
+    if (mm_init() < 0) {
+	fprintf(stderr, "fixedbench: mm_init failed\n");
+	exit(1);
+    }
+
+    pairs = (double)b.batch * b.rounds;
+    printf("%d objects per round, %d rounds\n", b.batch, b.rounds);
+    printf("%-8s%16s%16s%10s\n", "size", "mm_malloc cyc", "fixed cyc", "saved");
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+	b.size = benches[i].size;
+	var_cycles = fcyc(benches[i].var, &b) / pairs;
+	fixed_cycles = fcyc(benches[i].fixed, &b) / pairs;
+	printf("%-8lu%16.1f%16.1f%9.1f%%\n", (unsigned long)b.size,
+	       var_cycles, fixed_cycles,
+	       100.0 * (var_cycles - fixed_cycles) / var_cycles);
+    }
+
+    mem_deinit();
+    exit(0);
+}
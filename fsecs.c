@@ -1,42 +1,145 @@
 /****************************
  * High-level timing wrappers
  ****************************/
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
 #include "fsecs.h"
 #include "fcyc.h"
 #include "clock.h"
 #include "ftimer.h"
+#include "latency.h"
 #include "config.h"
 
-static double Mhz;  /* estimated CPU clock frequency */
+/* The timers, in the order of timer_names */
+enum {TIMER_GETTOD, TIMER_ITIMER, TIMER_FCYC, TIMER_MONO, TIMER_TSC};
+
+static const char *timer_names[] = {
+    "gettod", "itimer", "fcyc", "mono", "tsc", NULL
+};
+
+static int timer = USE_FCYC ? TIMER_FCYC : 
+    USE_ITIMER ? TIMER_ITIMER : TIMER_GETTOD;
+static int pin_cpu = -1;  /* CPU to run on, or -1 for any */
+static int warmup = 0;    /* untimed runs before each measurement */
+static double Mhz;        /* estimated CPU clock frequency */
+static double tsc_secs;   /* seconds per TSC tick */
 
 extern int verbose; /* -v option in mdriver.c */
 
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
+/* The clocks of the mono and tsc timers, for set_fcyc_clock() */
+static double mono_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double tsc_now(void)
+{
+    return (double)lat_ticks();
+}
+
+/*
+ * set_fsecs_timer - select a timer by name, before init_fsecs();
+ *     returns -1 if there is none by that name
+ */
+int set_fsecs_timer(const char *name)
+{
+    int i;
+
+    for (i = 0; timer_names[i] != NULL; i++) {
+	if (!strcmp(name, timer_names[i])) {
+	    timer = i;
+	    return 0;
+	}
+    }
+    return -1;
+}
+
+/*
+ * set_fsecs_cpu - run on this CPU only, from init_fsecs() on
+ */
+void set_fsecs_cpu(int cpu)
+{
+    pin_cpu = cpu;
+}
+
+/*
+ * set_fsecs_warmup - run the function n times untimed before timing it
+ */
+void set_fsecs_warmup(int n)
+{
+    warmup = n;
+}
+
 /*
  * init_fsecs - initialize the timing package
  */
 void init_fsecs(void)
 {
+    cpu_set_t set;
+
     Mhz = 0; /* keep gcc -Wall happy */
 
-#if USE_FCYC
-    if (verbose)
-	printf("Measuring performance with a cycle counter.\n");
-
-    /* set key parameters for the fcyc package */
-    set_fcyc_maxsamples(20); 
-    set_fcyc_clear_cache(1);
-    set_fcyc_compensate(1);
-    set_fcyc_epsilon(0.01);
-    set_fcyc_k(3);
-    Mhz = mhz(verbose > 0);
-#elif USE_ITIMER
-    if (verbose)
-	printf("Measuring performance with the interval timer.\n");
-#elif USE_GETTOD
-    if (verbose)
-	printf("Measuring performance with gettimeofday().\n");
-#endif
+    if (pin_cpu >= 0) {
+	CPU_ZERO(&set);
+	CPU_SET(pin_cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) < 0)
+	    fprintf(stderr, "Can't pin to CPU %d, running unpinned\n", pin_cpu);
+	else if (verbose)
+	    printf("Running on CPU %d only.\n", pin_cpu);
+    }
+
+    if (timer == TIMER_TSC && !lat_invariant()) {
+	fprintf(stderr, "The TSC rate isn't invariant, timing with mono\n");
+	timer = TIMER_MONO;
+    }
+
+    /* The cycle counters share the parameters of the fcyc package */
+    if (timer == TIMER_FCYC || timer == TIMER_MONO || timer == TIMER_TSC) {
+	set_fcyc_maxsamples(20); 
+	set_fcyc_clear_cache(1);
+	set_fcyc_compensate(1);
+	set_fcyc_epsilon(0.01);
+	set_fcyc_k(3);
+    }
+
+    switch (timer) {
+    case TIMER_FCYC:
+	if (verbose)
+	    printf("Measuring performance with a cycle counter.\n");
+	set_fcyc_clock(NULL);
+	Mhz = mhz(verbose > 0);
+	break;
+    case TIMER_MONO:
+	if (verbose)
+	    printf("Measuring performance with clock_gettime().\n");
+	set_fcyc_clock(mono_now);
+	break;
+    case TIMER_TSC:
+	tsc_secs = 1 / lat_hz();
+	if (verbose)
+	    printf("Measuring performance with rdtscp at %.0f MHz.\n",
+		   lat_hz() / 1e6);
+	set_fcyc_clock(tsc_now);
+	break;
+    case TIMER_ITIMER:
+	if (verbose)
+	    printf("Measuring performance with the interval timer.\n");
+	break;
+    default:
+	if (verbose)
+	    printf("Measuring performance with gettimeofday().\n");
+	break;
+    }
 }
 
 /*
@@ -44,14 +147,52 @@ void init_fsecs(void)
  */
 double fsecs(fsecs_test_funct f, void *argp) 
 {
-#if USE_FCYC
-    double cycles = fcyc(f, argp);
-    return cycles/(Mhz*1e6);
-#elif USE_ITIMER
-    return ftimer_itimer(f, argp, 10);
-#elif USE_GETTOD
-    return ftimer_gettod(f, argp, 10);
-#endif 
+    int i;
+
+    for (i = 0; i < warmup; i++)
+	f(argp);
+
+    switch (timer) {
+    case TIMER_FCYC:
+	return fcyc(f, argp)/(Mhz*1e6);
+    case TIMER_MONO:
+	return fcyc(f, argp);
+    case TIMER_TSC:
+	return fcyc(f, argp) * tsc_secs;
+    case TIMER_ITIMER:
+	return ftimer_itimer(f, argp, 10);
+    default:
+	return ftimer_gettod(f, argp, 10);
+    }
+}
+
+/*
+ * fsecs_once - Return the running time of a single run of f (in
+ *     seconds), with the same timer as fsecs(), for functions that
+ *     can't be rerun
+ */
+double fsecs_once(fsecs_test_funct f, void *argp)
+{
+    double start;
+
+    switch (timer) {
+    case TIMER_FCYC:
+	start_counter();
+	f(argp);
+	return get_counter()/(Mhz*1e6);
+    case TIMER_MONO:
+	start = mono_now();
+	f(argp);
+	return mono_now() - start;
+    case TIMER_TSC:
+	start = tsc_now();
+	f(argp);
+	return (tsc_now() - start) * tsc_secs;
+    case TIMER_ITIMER:
+	return ftimer_itimer(f, argp, 1);
+    default:
+	return ftimer_gettod(f, argp, 1);
+    }
 }
 
 
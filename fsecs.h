@@ -2,3 +2,10 @@ typedef void (*fsecs_test_funct)(void *);
 
 void init_fsecs(void);
 double fsecs(fsecs_test_funct f, void *argp);
+double fsecs_once(fsecs_test_funct f, void *argp);
+
+/* Choose the timer (gettod, itimer, fcyc, mono or tsc), the CPU to run
+   on and the untimed runs before each measurement, before init_fsecs() */
+int set_fsecs_timer(const char *name);
+void set_fsecs_cpu(int cpu);
+void set_fsecs_warmup(int n);
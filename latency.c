@@ -0,0 +1,211 @@
+/*
+ * latency.c - per-request latency histograms; see latency.h
+ */
+#include <stdio.h>
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "latency.h"
+
+#define CAL_PAIRS   1000      /* timestamp pairs to find the overhead */
+#define CAL_NSECS   20000000  /* ns to measure the counter's rate over */
+#define TSC_KHZ_FILE "/sys/devices/system/cpu/cpu0/tsc_freq_khz"
+
+static unsigned long long overhead; /* ticks of a back-to-back pair */
+static double ticks_per_ns = 1.0;
+static double hz;                   /* ticks per second, once known */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * tsc_hz - the TSC rate that the kernel or the CPU reports, or 0:
+ *     sysfs, then cpuid leaf 0x15 (crystal clock times the TSC ratio),
+ *     the hypervisor's leaf 0x40000010, and leaf 0x16 (base MHz)
+ */
+static double tsc_hz(void)
+{
+    FILE *fp;
+    double khz = 0;
+
+    if ((fp = fopen(TSC_KHZ_FILE, "r")) != NULL) {
+	if (fscanf(fp, "%lf", &khz) != 1)
+	    khz = 0;
+	fclose(fp);
+	if (khz > 0)
+	    return khz * 1e3;
+    }
+#if defined(__i386__) || defined(__x86_64__)
+    {
+	unsigned a, b, c, d, max = __get_cpuid_max(0, NULL);
+
+	if (max >= 0x15) {
+	    __cpuid(0x15, a, b, c, d);
+	    if (a != 0 && b != 0 && c != 0)
+		return (double)c * b / a;
+	}
+	__cpuid(0x1, a, b, c, d);
+	if (c & (1U << 31)) {          /* running under a hypervisor */
+	    __cpuid(0x40000000, a, b, c, d);
+	    if (a >= 0x40000010) {
+		__cpuid(0x40000010, a, b, c, d);
+		if (a != 0)
+		    return a * 1e3;
+	    }
+	}
+	if (max >= 0x16) {
+	    __cpuid(0x16, a, b, c, d);
+	    if (a != 0)
+		return a * 1e6;
+	}
+    }
+#endif
+    return 0;
+}
+
+/*
+ * lat_hz - the ticks of lat_ticks() per second: as reported where
+ *     the clock is the TSC and its rate is reported, or else measured
+ *     against the monotonic clock over CAL_NSECS, spinning, not sleeping
+ */
+double lat_hz(void)
+{
+    unsigned long long t0, t1;
+    double ns;
+
+    if (hz > 0)
+	return hz;
+#if defined(__i386__) || defined(__x86_64__)
+    hz = tsc_hz();
+#else
+    hz = 1e9;
+#endif
+    if (hz <= 0) {
+	ns = now_ns();
+	t0 = lat_ticks();
+	while (now_ns() - ns < CAL_NSECS)
+	    ;
+	t1 = lat_ticks();
+	hz = (t1 - t0) / (now_ns() - ns) * 1e9;
+    }
+    return hz;
+}
+
+/*
+ * lat_invariant - does the TSC tick at the same rate in every P-, C-
+ *     and T-state (cpuid 0x80000007, edx bit 8)? Always true for the
+ *     monotonic clock
+ */
+int lat_invariant(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned a, b, c, d;
+
+    if (__get_cpuid_max(0x80000000, NULL) < 0x80000007)
+	return 0;
+    __cpuid(0x80000007, a, b, c, d);
+    return (d >> 8) & 1;
+#else
+    return 1;
+#endif
+}
+
+/*
+ * lat_init - calibrate: the smallest difference of two back-to-back
+ *     timestamps, and the ticks per ns
+ */
+void lat_init(void)
+{
+    unsigned long long t0, t1;
+    int i;
+
+    overhead = ~0ULL;
+    for (i = 0; i < CAL_PAIRS; i++) {
+	t0 = lat_ticks();
+	t1 = lat_ticks();
+	if (t1 - t0 < overhead)
+	    overhead = t1 - t0;
+    }
+    ticks_per_ns = lat_hz() / 1e9;
+}
+
+/*
+ * bucket - the histogram bucket of a sample. Above LAT_SUB, the top
+ *     LAT_SUB_BITS bits of the sample pick one of LAT_SUB/2 buckets in
+ *     its power of two.
+ */
+static int bucket(unsigned long long v)
+{
+    int msb, shift;
+
+    if (v < LAT_SUB)
+	return v;
+    if (v >= 1ULL << LAT_MAX_BITS)
+	v = (1ULL << LAT_MAX_BITS) - 1;
+    for (msb = LAT_SUB_BITS; v >> (msb + 1); msb++)
+	;
+    shift = msb - LAT_SUB_BITS + 1;
+    return LAT_SUB + (shift - 1) * LAT_SUB / 2 + (v >> shift) - LAT_SUB / 2;
+}
+
+/*
+ * highest - the largest sample that falls in bucket b
+ */
+static unsigned long long highest(int b)
+{
+    int shift;
+
+    if (b < LAT_SUB)
+	return b;
+    shift = (b - LAT_SUB) / (LAT_SUB / 2) + 1;
+    return ((unsigned long long)((b - LAT_SUB) % (LAT_SUB / 2) + LAT_SUB / 2 + 1)
+	    << shift) - 1;
+}
+
+/*
+ * lat_record - add a sample of ticks, less the timestamp overhead
+ */
+void lat_record(lat_hist_t *h, unsigned long long ticks)
+{
+    ticks = (ticks > overhead) ? ticks - overhead : 0;
+    h->count[bucket(ticks)]++;
+    h->n++;
+    if (ticks > h->max)
+	h->max = ticks;
+}
+
+/*
+ * lat_percentile - the sample at or below which pct percent of the
+ *     samples fall, as the top of its bucket; pct 100 is the maximum
+ */
+unsigned long long lat_percentile(const lat_hist_t *h, double pct)
+{
+    unsigned long rank = (unsigned long)(pct / 100.0 * h->n + 0.999999);
+    unsigned long seen = 0;
+    int b;
+
+    if (h->n == 0)
+	return 0;
+    if (rank < 1)
+	rank = 1;
+    for (b = 0; b < LAT_BUCKETS; b++) {
+	if ((seen += h->count[b]) >= rank)
+	    return (highest(b) < h->max) ? highest(b) : h->max;
+    }
+    return h->max;
+}
+
+/*
+ * lat_ns - ticks in ns, at the rate lat_init() measured
+ */
+double lat_ns(unsigned long long ticks)
+{
+    return ticks / ticks_per_ns;
+}
@@ -0,0 +1,54 @@
+/*
+ * latency.h - per-request latency timestamps and log-bucketed histograms
+ *
+ * lat_ticks() reads the time stamp counter with rdtscp on x86, which
+ * waits for the instructions before it to finish, or the monotonic
+ * clock in ns elsewhere. lat_hz() is the counter's rate, read from
+ * sysfs or cpuid where they give it and measured otherwise, and
+ * lat_invariant() whether that rate holds in every power state.
+ * lat_init() measures the cost of a pair of timestamps, which
+ * lat_record() takes off each sample; lat_ns() converts ticks to ns.
+ *
+ * The histograms are HDR-style: exact below LAT_SUB ticks, then
+ * LAT_SUB/2 buckets per power of two, so a reported value is within
+ * about 3% of the true one.
+ */
+#ifndef __LATENCY_H_
+#define __LATENCY_H_
+
+#include <time.h>
+
+#define LAT_SUB_BITS 6
+#define LAT_SUB      (1 << LAT_SUB_BITS)
+#define LAT_MAX_BITS 40   /* larger samples count as 2^40 - 1 ticks */
+#define LAT_BUCKETS  (LAT_SUB + (LAT_MAX_BITS - LAT_SUB_BITS) * LAT_SUB / 2)
+
+typedef struct {
+    unsigned long count[LAT_BUCKETS];
+    unsigned long n;              /* samples */
+    unsigned long long max;       /* largest sample, in ticks */
+} lat_hist_t;
+
+static inline unsigned long long lat_ticks(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned hi, lo;
+
+    __asm__ __volatile__("rdtscp" : "=a" (lo), "=d" (hi) : : "ecx");
+    return ((unsigned long long)hi << 32) | lo;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+double lat_hz(void);
+int lat_invariant(void);
+void lat_init(void);
+void lat_record(lat_hist_t *h, unsigned long long ticks);
+unsigned long long lat_percentile(const lat_hist_t *h, double pct);
+double lat_ns(unsigned long long ticks);
+
+#endif /* __LATENCY_H_ */
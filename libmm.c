@@ -0,0 +1,223 @@
+/*
+ * libmm.c - the mm.c allocator as the process malloc. Built as libmm.so
+ *     ("make libmm.so") and loaded with LD_PRELOAD, it replaces the libc
+ *     malloc family for a native program:
+ *
+ *         unix> LD_PRELOAD=./libmm.so sort bigfile
+ *
+ *     The heap is memlib's default heap, a single MAX_HEAP mapping, and
+ *     one lock serializes every call into mm.c. Nothing is forwarded to
+ *     the libc allocator, so there is no dlsym() lookup to bootstrap:
+ *     the first call, however early, maps the heap and initializes mm.c.
+ *     Around fork() the lock is held, so the child gets a consistent
+ *     heap and a fresh lock.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+
+#define EXPORT __attribute__((visibility("default")))
+
+/* private variables */
+static pthread_mutex_t mm_lock = PTHREAD_MUTEX_INITIALIZER;
+static int mm_ready = 0;  /* heap mapped and mm_init() done */
+
+/*
+ * lock - take the allocator lock, setting up the heap on first use
+ */
+static void lock(void)
+{
+    pthread_mutex_lock(&mm_lock);
+    if (!mm_ready) {
+	mem_init();
+	if (mm_init() < 0) {
+	    fprintf(stderr, "libmm: mm_init failed\n");
+	    abort();
+	}
+	mm_ready = 1;
+    }
+}
+
+static void unlock(void)
+{
+    pthread_mutex_unlock(&mm_lock);
+}
+
+/*
+ * fork handlers - hold the lock across fork() so no other thread is
+ *     inside mm.c when the child's copy of the heap is taken
+ */
+static void fork_prepare(void)
+{
+    lock();
+}
+
+static void fork_parent(void)
+{
+    unlock();
+}
+
+static void fork_child(void)
+{
+    pthread_mutex_init(&mm_lock, NULL);
+}
+
+/*
+ * libmm_init - register the fork handlers when the library is loaded.
+ *     pthread_atfork() may itself call malloc, which is fine here since
+ *     the lock is not held.
+ */
+__attribute__((constructor))
+static void libmm_init(void)
+{
+    pthread_atfork(fork_prepare, fork_parent, fork_child);
+}
+
+/*
+ * aligned - allocate size bytes aligned to align, for the memalign
+ *     family. Returns NULL with errno set on failure.
+ */
+static void *aligned(size_t align, size_t size)
+{
+    void *p;
+
+    if (align == 0 || (align & (align - 1)) != 0) {
+	errno = EINVAL;
+	return NULL;
+    }
+    if (size >= MAX_HEAP) {
+	errno = ENOMEM;
+	return NULL;
+    }
+    lock();
+    p = mm_memalign(align, size ? size : 1);
+    unlock();
+    if (p == NULL)
+	errno = ENOMEM;
+    return p;
+}
+
+/*
+ * The exported malloc family. Requests of 0 bytes return a unique
+ * minimum-sized block, as glibc does.
+ */
+EXPORT void *malloc(size_t size)
+{
+    void *p;
+
+    if (size >= MAX_HEAP) {
+	errno = ENOMEM;
+	return NULL;
+    }
+    lock();
+    p = mm_malloc(size ? size : 1);
+    unlock();
+    if (p == NULL)
+	errno = ENOMEM;
+    return p;
+}
+
+EXPORT void free(void *ptr)
+{
+    if (ptr == NULL)
+	return;
+    lock();
+    mm_free(ptr);
+    unlock();
+}
+
+EXPORT void *realloc(void *ptr, size_t size)
+{
+    void *p;
+
+    if (ptr == NULL)
+	return malloc(size);
+    if (size == 0) {
+	free(ptr);
+	return NULL;
+    }
+    if (size >= MAX_HEAP) {
+	errno = ENOMEM;
+	return NULL;
+    }
+    lock();
+    p = mm_realloc(ptr, size);
+    unlock();
+    if (p == NULL)
+	errno = ENOMEM;
+    return p;
+}
+
+EXPORT void *calloc(size_t nmemb, size_t size)
+{
+    void *p;
+
+    if (nmemb == 0 || size == 0)
+	nmemb = size = 1;
+    if (nmemb > (MAX_HEAP - 1) / size) {
+	errno = ENOMEM;
+	return NULL;
+    }
+    lock();
+    p = mm_calloc(nmemb, size);
+    unlock();
+    if (p == NULL)
+	errno = ENOMEM;
+    return p;
+}
+
+EXPORT int posix_memalign(void **memptr, size_t align, size_t size)
+{
+    void *p;
+
+    if (align % sizeof(void *) != 0)
+	return EINVAL;
+    if ((p = aligned(align, size)) == NULL)
+	return errno;
+    *memptr = p;
+    return 0;
+}
+
+EXPORT void *aligned_alloc(size_t align, size_t size)
+{
+    return aligned(align, size);
+}
+
+EXPORT size_t malloc_usable_size(void *ptr)
+{
+    size_t size;
+
+    if (ptr == NULL)
+	return 0;
+    lock();
+    size = mm_usable_size(ptr);
+    unlock();
+    return size;
+}
+
+/*
+ * Obsolete entry points. Programs still call them, and a block from
+ * the libc allocator must never reach mm_free().
+ */
+EXPORT void *memalign(size_t align, size_t size)
+{
+    return aligned(align, size);
+}
+
+EXPORT void *valloc(size_t size)
+{
+    return aligned(mem_pagesize(), size);
+}
+
+EXPORT void *pvalloc(size_t size)
+{
+    size_t pagesize = mem_pagesize();
+
+    return aligned(pagesize, (size + pagesize - 1) & ~(pagesize - 1));
+}
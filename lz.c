@@ -0,0 +1,146 @@
+/*
+ * lz.c - a small LZ77 block codec
+ *
+ * The compressor is greedy: it hashes the 4 bytes at each position,
+ * looks up the last position with the same hash, and takes the match
+ * there if the bytes agree. The decompressor checks every length and
+ * offset against its input and output, so a corrupt block fails
+ * instead of writing out of bounds.
+ */
+#include <string.h>
+
+#include "lz.h"
+
+#define MIN_MATCH  4
+#define MAX_OFFSET 65535
+#define HASH_BITS  14
+
+typedef unsigned char byte;
+
+static unsigned hash4(const byte *p)
+{
+    unsigned v;
+
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/*
+ * put_len - write the part of a length that didn't fit in its nibble
+ */
+static byte *put_len(byte *op, size_t len)
+{
+    for (; len >= 255; len -= 255)
+	*op++ = 255;
+    *op++ = len;
+    return op;
+}
+
+/*
+ * put_seq - write nlit literals from lit, then a match of mlen bytes
+ *     at offset back, or no match if mlen is 0
+ */
+static byte *put_seq(byte *op, const byte *lit, size_t nlit,
+		     size_t offset, size_t mlen)
+{
+    size_t mcode = mlen ? mlen - MIN_MATCH : 0;
+    byte *token = op++;
+
+    *token = ((nlit < 15 ? nlit : 15) << 4) | (mcode < 15 ? mcode : 15);
+    if (nlit >= 15)
+	op = put_len(op, nlit - 15);
+    memcpy(op, lit, nlit);
+    op += nlit;
+    if (mlen == 0)
+	return op;
+    *op++ = offset & 0xff;
+    *op++ = offset >> 8;
+    if (mcode >= 15)
+	op = put_len(op, mcode - 15);
+    return op;
+}
+
+size_t lz_compress(const void *src, size_t n, void *dst)
+{
+    unsigned table[1 << HASH_BITS];
+    const byte *in = src, *ip = in, *anchor = in, *end = in + n;
+    const byte *ref;
+    byte *op = dst;
+    size_t len;
+    unsigned h;
+
+    memset(table, 0, sizeof(table));
+    while (n >= MIN_MATCH && ip <= end - MIN_MATCH) {
+	h = hash4(ip);
+	ref = in + table[h];
+	table[h] = ip - in;
+	if (ref >= ip || ip - ref > MAX_OFFSET ||
+	    memcmp(ref, ip, MIN_MATCH) != 0) {
+	    ip++;
+	    continue;
+	}
+	for (len = MIN_MATCH; ip + len < end && ref[len] == ip[len]; len++)
+	    ;
+	op = put_seq(op, anchor, ip - anchor, ip - ref, len);
+	ip += len;
+	anchor = ip;
+    }
+    op = put_seq(op, anchor, end - anchor, 0, 0);
+    return op - (byte *)dst;
+}
+
+/*
+ * get_len - add the extra bytes of a length to len, or return -1
+ */
+static long get_len(const byte **ipp, const byte *iend, size_t len)
+{
+    const byte *ip = *ipp;
+    byte b;
+
+    do {
+	if (ip == iend)
+	    return -1;
+	b = *ip++;
+	len += b;
+    } while (b == 255);
+    *ipp = ip;
+    return len;
+}
+
+long lz_decompress(const void *src, size_t n, void *dst, size_t cap)
+{
+    const byte *ip = src, *iend = ip + n;
+    byte *out = dst, *op = out, *oend = out + cap;
+    const byte *ref;
+    long nlit, mlen;
+    size_t offset;
+    byte token;
+
+    while (ip < iend) {
+	token = *ip++;
+	nlit = token >> 4;
+	if (nlit == 15 && (nlit = get_len(&ip, iend, nlit)) < 0)
+	    return -1;
+	if (nlit > iend - ip || nlit > oend - op)
+	    return -1;
+	memcpy(op, ip, nlit);
+	ip += nlit;
+	op += nlit;
+	if (ip == iend)
+	    break;  /* the last sequence has no match */
+
+	if (iend - ip < 2)
+	    return -1;
+	offset = ip[0] | (ip[1] << 8);
+	ip += 2;
+	mlen = token & 15;
+	if (mlen == 15 && (mlen = get_len(&ip, iend, mlen)) < 0)
+	    return -1;
+	mlen += MIN_MATCH;
+	if (offset == 0 || offset > op - out || mlen > oend - op)
+	    return -1;
+	for (ref = op - offset; mlen > 0; mlen--)
+	    *op++ = *ref++;  /* may overlap: copy forward a byte at a time */
+    }
+    return op - out;
+}
@@ -0,0 +1,23 @@
+/*
+ * lz.h - a small LZ77 block codec, for compressed binary traces
+ *
+ * A compressed block is a run of sequences, each a token byte, a
+ * literal run, and a back reference (2-byte offset, length >= 4) into
+ * the bytes already decoded. The last sequence has literals only. The
+ * format is close to LZ4's, but shares no code with it.
+ */
+#ifndef __LZ_H_
+#define __LZ_H_
+
+#include <stddef.h>
+
+/* Largest compressed size of n bytes */
+#define LZ_BOUND(n) ((n) + (n) / 255 + 16)
+
+/* Compress n bytes from src into dst, which holds LZ_BOUND(n) bytes */
+extern size_t lz_compress(const void *src, size_t n, void *dst);
+
+/* Decompress n bytes from src into dst; -1 if corrupt or over cap bytes */
+extern long lz_decompress(const void *src, size_t n, void *dst, size_t cap);
+
+#endif /* __LZ_H_ */
@@ -0,0 +1,191 @@
+/*
+ * mdcompare.c - compare two builds of the driver, run by run
+ *
+ * One mdriver run gives one number per trace, with no sense of its
+ * noise, and two runs one after the other see different machine
+ * states. mdcompare runs two mdriver binaries (say, built from the old
+ * and the new mm.c) alternately, -r rounds of each in the order ABBA
+ * so that drift over the rounds falls on both alike, and prints each
+ * trace's mean throughput and its 95% confidence interval for both,
+ * the difference, and how sure it is:
+ *
+ *     unix> cp mdriver mdriver-old; (edit mm.c); make
+ *     unix> mdcompare -r 10 ./mdriver-old ./mdriver -k tsc -p 2
+ *
+ * Arguments after the two binaries go to both. The differences are
+ * marked * if Welch's t-test finds them significant at the 5% level,
+ * and ** at the 1% level.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "runstats.h"
+
+#define MAXTRACES 256
+#define MAXLINE   1024
+
+/* The measurements of one binary */
+typedef struct {
+    const char *path;
+    double *kops[MAXTRACES];   /* throughput in each round */
+    double util[MAXTRACES];
+    double ops[MAXTRACES];
+} side_t;
+
+static char names[MAXTRACES][MAXLINE];
+static int ntraces;
+
+/*
+ * run - run the binary once with the shared arguments, and record the
+ *     util and throughput of each trace as round r; returns -1 if it
+ *     fails or doesn't time every trace
+ */
+static int run(side_t *s, const char *args, int r, int rounds)
+{
+    char cmd[4 * MAXLINE], line[MAXLINE], name[MAXLINE];
+    FILE *fp;
+    double util, ops, kops;
+    int i, n = 0, status;
+
+    snprintf(cmd, sizeof(cmd), "'%s' -a -G -r 1%s", s->path, args);
+    if ((fp = popen(cmd, "r")) == NULL) {
+	perror(cmd);
+	return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	if (sscanf(line, "trace:%d:%1023[^:]:%lf:%lf:%lf", &i, name, &util,
+		   &ops, &kops) != 5 || i < 0 || i >= MAXTRACES)
+	    continue;
+	if (s->kops[i] == NULL &&
+	    (s->kops[i] = calloc(rounds, sizeof(double))) == NULL) {
+	    fprintf(stderr, "mdcompare: out of memory\n");
+	    exit(1);
+	}
+	strcpy(names[i], name);
+	s->kops[i][r] = kops;
+	s->util[i] = util;
+	s->ops[i] = ops;
+	if (i >= ntraces)
+	    ntraces = i + 1;
+	n++;
+    }
+    status = pclose(fp);
+    if (n == 0 || n < ntraces || status != 0) {
+	fprintf(stderr, "mdcompare: %s failed\n", cmd);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * printrow - one line of the comparison
+ */
+static void printrow(const char *label, const char *name, const double *a,
+		     const double *b, int rounds, double ua, double ub)
+{
+    runstats_t ra, rb;
+    static const char *marks[] = {"", " *", " **"};
+
+    runstats(a, rounds, &ra);
+    runstats(b, rounds, &rb);
+    printf("%5s %-20.20s%5.1f%%%5.1f%%%9.0f%6.1f%%%9.0f%6.1f%%%+8.1f%%%s\n",
+	   label, name, ua * 100, ub * 100, ra.mean, ra.ci / ra.mean * 100,
+	   rb.mean, rb.ci / rb.mean * 100, (rb.mean / ra.mean - 1) * 100,
+	   marks[welch(&ra, &rb)]);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: mdcompare [-h] [-r <n>] <mdriverA> <mdriverB> [<mdriver args>]\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h      Print this message.\n");
+    fprintf(stderr, "\t-r <n>  Rounds of runs of each binary (default 5).\n");
+}
+
+int main(int argc, char **argv)
+{
+    side_t side[2];
+    char args[2 * MAXLINE] = "", label[16];
+    double *ta, *tb, sa, sb;
+    int rounds = 5, c, i, r, first;
+
+    while ((c = getopt(argc, argv, "+hr:")) != EOF) {
+	switch (c) {
+	case 'r':
+	    rounds = atoi(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (argc - optind < 2 || rounds < 2) {
+	usage();
+	exit(1);
+    }
+    memset(side, 0, sizeof(side));
+    side[0].path = argv[optind];
+    side[1].path = argv[optind + 1];
+    for (i = optind + 2; i < argc; i++) {
+	if (strlen(args) + strlen(argv[i]) + 4 > sizeof(args)) {
+	    fprintf(stderr, "mdcompare: arguments too long\n");
+	    exit(1);
+	}
+	strcat(args, " '");
+	strcat(args, argv[i]);
+	strcat(args, "'");
+    }
+
+    /* Rounds in the order AB BA AB ... */
+    for (r = 0; r < rounds; r++) {
+	first = r % 2;
+	if (run(&side[first], args, r, rounds) < 0 ||
+	    run(&side[1 - first], args, r, rounds) < 0)
+	    exit(1);
+	fprintf(stderr, "\rround %d of %d", r + 1, rounds);
+    }
+    fprintf(stderr, "\n");
+
+    printf("A: %s\nB: %s\n\n", side[0].path, side[1].path);
+    printf("%5s %-20s%6s%6s%9s%7s%9s%7s%9s\n", "trace", "name", "utilA",
+	   "utilB", "A Kops", "95%", "B Kops", "95%", "B vs A");
+    for (i = 0; i < ntraces; i++) {
+	if (side[0].kops[i] == NULL || side[1].kops[i] == NULL)
+	    continue;
+	snprintf(label, sizeof(label), "%d", i);
+	printrow(label, names[i], side[0].kops[i], side[1].kops[i], rounds,
+		 side[0].util[i], side[1].util[i]);
+    }
+
+    /* The throughput of all the traces in each round, and mean util */
+    ta = calloc(rounds, sizeof(double));
+    tb = calloc(rounds, sizeof(double));
+    if (ta == NULL || tb == NULL) {
+	fprintf(stderr, "mdcompare: out of memory\n");
+	exit(1);
+    }
+    for (r = 0; r < rounds; r++) {
+	double opsum = 0;
+
+	for (sa = sb = 0, i = 0; i < ntraces; i++) {
+	    if (side[0].kops[i] == NULL || side[1].kops[i] == NULL)
+		continue;
+	    opsum += side[0].ops[i];
+	    sa += side[0].ops[i] / side[0].kops[i][r];
+	    sb += side[1].ops[i] / side[1].kops[i][r];
+	}
+	ta[r] = opsum / sa;
+	tb[r] = opsum / sb;
+    }
+    for (sa = sb = 0, i = 0; i < ntraces; i++) {
+	sa += side[0].util[i] / ntraces;
+	sb += side[1].util[i] / ntraces;
+    }
+    printrow("Total", "", ta, tb, rounds, sa, sb);
+    exit(0);
+}
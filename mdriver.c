@@ -18,7 +18,13 @@
 
 #include "mm.h"
 #include "memlib.h"
+#include "region.h"
 #include "fsecs.h"
+#include "ftimer.h"
+#include "trace.h"
+#include "latency.h"
+#include "perfctr.h"
+#include "runstats.h"
 #include "config.h"
 
 /**********************
@@ -29,9 +35,13 @@
 #define MAXLINE     1024 /* max string size */
 #define HDRLINES       4 /* number of header lines in a trace file */
 #define LINENUM(i) (i+5) /* cnvt trace request nums to linenums (origin 1) */
+#define RSS_SAMPLE    64 /* requests between counts of resident pages (-M) */
+#define NUM_OP_TYPES   7 /* request types in trace.h, for -H */
+#define MAX_LIMITS     8 /* latency limits with -P */
+#define PERF_RUNS      3 /* replays to count events over, keeping the least */
 
-/* Returns true if p is ALIGNMENT-byte aligned */
-#define IS_ALIGNED(p)  ((((unsigned int)(p)) % ALIGNMENT) == 0)
+/* Returns true if p is a-byte aligned */
+#define IS_ALIGNED(p, a)  ((((unsigned int)(p)) % (a)) == 0)
 
 /****************************** 
  * The key compound data types 
@@ -44,22 +54,21 @@ typedef struct range_t {
     struct range_t *next;  /* next list element */
 } range_t;
 
-/* Characterizes a single trace operation (allocator request) */
-typedef struct {
-    enum {ALLOC, FREE, REALLOC} type; /* type of request */
-    int index;                        /* index for free() to use later */
-    int size;                         /* byte size of alloc/realloc request */
-} traceop_t;
-
 /* Holds the information for one trace file*/
 typedef struct {
     int sugg_heapsize;   /* suggested heap size (unused) */
     int num_ids;         /* number of alloc/realloc ids */
     int num_ops;         /* number of distinct requests */
+    int num_reqs;        /* number of block requests (batches count each) */
     int weight;          /* weight for this trace (unused) */
-    traceop_t *ops;      /* array of requests */
+    traceop_t *ops;      /* array of requests win_start..win_end-1 */
+    int win_start;       /* all of them, unless the trace is streamed */
+    int win_end;
     char **blocks;       /* array of ptrs returned by malloc/realloc... */
     size_t *block_sizes; /* ... and a corresponding array of payload sizes */
+    tracefile_t file;    /* the loaded trace file behind ops... */
+    tracestream_t *stream; /* ...or the stream, with -S */
+    double stall_secs;   /* decode stalls in the last timed run, with -S */
 } trace_t;
 
 /* 
@@ -70,6 +79,9 @@ typedef struct {
 typedef struct {
     trace_t *trace;  
     range_t *ranges;
+    int snap_op;              /* request after which to take... */
+    mm_heap_stats_t *snap;    /* ...a snapshot of the heap, or -1 */
+    lat_hist_t *lat;          /* latency of each request type, or NULL */
 } speed_t;
 
 /* Summarizes the important stats for some malloc function on some trace */
@@ -81,6 +93,14 @@ typedef struct {
 
     /* defined only for the student malloc package */
     double util;     /* space utilization for this trace (always 0 for libc) */
+    double frag[4];  /* the rest of the heap at peak, with -F: metadata,
+			internal slack, realloc reserve and free blocks */
+    double foot[3];  /* footprint over the trace, with -M: time-weighted
+			util, the same against resident pages, peak RSS */
+    lat_hist_t *lat; /* latency of each request type, with -H */
+    double perf[PERF_NUM]; /* event counts of a replay, with -C; -1 for
+			      counters that aren't available */
+    double *runs;    /* the secs of each of the -r timings; secs is their mean */
 
     /* Note: secs and util are only defined if valid is true */
 } stats_t; 
@@ -89,6 +109,22 @@ typedef struct {
  * Global variables
  *******************/
 int verbose = 0;        /* global flag for verbose output */
+static int region_mode = 0; /* replay through an mm_region_t (-R) */
+static int batch_split = 0; /* replay batch ops one block at a time (-b) */
+static int stream_mode = 0; /* stream traces instead of loading them (-S) */
+static int age_passes = 0;  /* passes over the traces on one heap (-A) */
+static int sample_ops = 0;  /* requests between timeline samples (-T) */
+static int frag_mode = 0;   /* break down the heap at peak payload (-F) */
+static int foot_mode = 0;   /* integrate the footprint over the trace (-M) */
+static int lat_mode = 0;    /* time each request into histograms (-H) */
+static int perf_mode = 0;   /* count hardware events in a replay (-C) */
+static int reps = 1;        /* timings of each trace (-r) */
+static int run_lines = 0;   /* print each run of each trace (-G) */
+static int num_limits = 0;  /* latency limits (-P): percentile... */
+static double limit_pct[MAX_LIMITS];
+static double limit_ns[MAX_LIMITS]; /* ...and most ns it may take */
+static FILE *timeline;      /* the current trace's timeline CSV */
+static int aging = 0;       /* replaying on the aged heap: don't reset it */
 static int errors = 0;  /* number of errs found when running student malloc */
 char msg[MAXLINE];      /* for whenever we need to compose an error message */
 
@@ -100,33 +136,78 @@ static char *default_tracefiles[] = {
     DEFAULT_TRACEFILES, NULL
 };
 
+/* Names of the request types in trace.h, for the latency tables */
+static char *op_names[NUM_OP_TYPES] = {
+    "malloc", "free", "realloc", "reset", "mallocb", "freeb", "calloc"
+};
+
 
 /********************* 
  * Function prototypes 
  *********************/
 
 /* these functions manipulate range lists */
-static int add_range(range_t **ranges, char *lo, int size, 
+static int add_range(range_t **ranges, char *lo, int size, int align,
 		     int tracenum, int opnum);
 static void remove_range(range_t **ranges, char *lo);
+static int usable_extent(char *p, int size, int tracenum, int opnum);
 static void clear_ranges(range_t **ranges);
 
 /* These functions read, allocate, and free storage for traces */
 static trace_t *read_trace(char *tracedir, char *filename);
 static void free_trace(trace_t *trace);
+static traceop_t *load_window(trace_t *trace, int i);
+static void rewind_trace(trace_t *trace);
+
+/*
+ * trace_op - return request i of trace. Each replay loop visits the
+ *     requests in order, so a streamed trace only ever moves to the
+ *     next window, or back to the start for the next pass.
+ */
+static inline traceop_t *trace_op(trace_t *trace, int i)
+{
+    if (i >= trace->win_start && i < trace->win_end)
+	return &trace->ops[i - trace->win_start];
+    return load_window(trace, i);
+}
 
 /* Routines for evaluating the correctness and speed of libc malloc */
 static int eval_libc_valid(trace_t *trace, int tracenum);
 static void eval_libc_speed(void *ptr);
 
+/* Batch ops, through the batch API or one block at a time */
+static int batch_alloc(mm_region_t *region, int size, int count, 
+		       char **blocks);
+static void batch_free(int count, char **blocks);
+
+/* Single allocations, with the alignment the trace asks for */
+static char *block_alloc(mm_region_t *region, int align, int size);
+static char *libc_alloc(int align, int size);
+static char *block_calloc(mm_region_t *region, int nmemb, int size);
+
 /* Routines for evaluating correctnes, space utilization, and speed 
    of the student's malloc package in mm.c */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges);
-static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges);
+static int check_requests(trace_t *trace, int tracenum, range_t **ranges,
+			  mm_region_t *region);
+static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges,
+			   double *frag, double *foot);
+static void frag_breakdown(trace_t *trace, char *live, double *frag);
+static void touch_payload(char *p, int size);
 static void eval_mm_speed(void *ptr);
+static double replay_secs(fsecs_test_funct f, speed_t *params);
+static int peak_payload(trace_t *trace, int *peak_op);
+static void age_heap(char **tracefiles, int n, int passes);
+static FILE *open_timeline(char *tracefile);
+static void sample_heap(int opnum, int live, int bin_peak);
 
 /* Various helper routines */
-static void printresults(int n, stats_t *stats);
+static void printresults(int n, stats_t *stats, int mm);
+static int parse_limits(char *spec);
+static int printlatency(int n, stats_t *stats);
+static void count_events(speed_t *params, double *counts);
+static void printcounters(int n, stats_t *stats);
+static void printruns(int n, stats_t *stats);
 static void usage(void);
 static void unix_error(char *msg);
 static void malloc_error(int tracenum, int opnum, char *msg);
@@ -137,7 +218,7 @@ static void app_error(char *msg);
  **************/
 int main(int argc, char **argv)
 {
-    int i;
+    int i, j;
     char c;
     char **tracefiles = NULL;  /* null-terminated array of trace file names */
     int num_tracefiles = 0;    /* the number of traces in that array */
@@ -147,6 +228,8 @@ int main(int argc, char **argv)
     stats_t *mm_stats = NULL;  /* mm (i.e. student) stats for each trace */
     speed_t speed_params;      /* input parameters to the xx_speed routines */ 
 
+    int lat_failures = 0;      /* latencies over the -P limits */
+
     int team_check = 1;  /* If set, check team structure (reset by -a) */
     int run_libc = 0;    /* If set, run libc malloc (set by -l) */
     int autograder = 0;  /* If set, emit summary info for autograder (-g) */
@@ -158,11 +241,14 @@ int main(int argc, char **argv)
     /* 
      * Read and interpret the command line arguments 
      */
-    while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF) {
+    while ((c = getopt(argc, argv, "f:t:hvVgGalRbSFMHCA:T:P:k:p:w:r:")) != EOF) {
         switch (c) {
 	case 'g': /* Generate summary info for the autograder */
 	    autograder = 1;
 	    break;
+	case 'G': /* Print the result of each run, for mdcompare */
+	    run_lines = 1;
+	    break;
         case 'f': /* Use one specific trace file only (relative to curr dir) */
             num_tracefiles = 1;
             if ((tracefiles = realloc(tracefiles, 2*sizeof(char *))) == NULL)
@@ -184,6 +270,64 @@ int main(int argc, char **argv)
         case 'l': /* Run libc malloc */
             run_libc = 1;
             break;
+        case 'R': /* Replay allocations through a region */
+            region_mode = 1;
+            break;
+        case 'b': /* Replay batch ops one block at a time */
+            batch_split = 1;
+            break;
+        case 'S': /* Stream traces through a prefetch thread */
+            stream_mode = 1;
+            break;
+        case 'A': /* Age one heap over passes of the traces */
+            if ((age_passes = atoi(optarg)) < 1) {
+		usage();
+		exit(1);
+	    }
+            break;
+        case 'F': /* Break down the heap at peak payload */
+            frag_mode = 1;
+            break;
+        case 'M': /* Integrate the footprint over each trace */
+            foot_mode = 1;
+            break;
+        case 'H': /* Histogram the latency of each request */
+            lat_mode = 1;
+            break;
+        case 'C': /* Count hardware events per request */
+            perf_mode = 1;
+            break;
+        case 'P': /* Fail if latencies exceed these limits */
+            if (parse_limits(optarg) < 0) {
+		usage();
+		exit(1);
+	    }
+            lat_mode = 1;
+            break;
+        case 'T': /* Sample the heap every n requests into a CSV */
+            if ((sample_ops = atoi(optarg)) < 1) {
+		usage();
+		exit(1);
+	    }
+            break;
+        case 'k': /* Time with this timer */
+            if (set_fsecs_timer(optarg) < 0) {
+		usage();
+		exit(1);
+	    }
+            break;
+        case 'p': /* Run on this CPU only */
+            set_fsecs_cpu(atoi(optarg));
+            break;
+        case 'r': /* Time each trace n times */
+            if ((reps = atoi(optarg)) < 1) {
+		usage();
+		exit(1);
+	    }
+            break;
+        case 'w': /* Run each trace untimed before timing it */
+            set_fsecs_warmup(atoi(optarg));
+            break;
         case 'v': /* Print per-trace performance breakdown */
             verbose = 1;
             break;
@@ -237,6 +381,17 @@ int main(int argc, char **argv)
 
     /* Initialize the timing package */
     init_fsecs();
+    if (lat_mode)
+	lat_init();
+    if (perf_mode && (i = perf_open()) < PERF_NUM) {
+	if (i == 0) {
+	    printf("Hardware counters unavailable (%s), ignoring -C\n",
+		   perf_error());
+	    perf_mode = 0;
+	} else
+	    printf("Only %d of %d hardware counters available (%s)\n",
+		   i, PERF_NUM, perf_error());
+    }
 
     /*
      * Optionally run and evaluate the libc malloc package 
@@ -253,7 +408,7 @@ int main(int argc, char **argv)
 	/* Evaluate the libc malloc package using the K-best scheme */
 	for (i=0; i < num_tracefiles; i++) {
 	    trace = read_trace(tracedir, tracefiles[i]);
-	    libc_stats[i].ops = trace->num_ops;
+	    libc_stats[i].ops = trace->num_reqs;
 	    if (verbose > 1)
 		printf("Checking libc malloc for correctness, ");
 	    libc_stats[i].valid = eval_libc_valid(trace, i);
@@ -261,7 +416,8 @@ int main(int argc, char **argv)
 		speed_params.trace = trace;
 		if (verbose > 1)
 		    printf("and performance.\n");
-		libc_stats[i].secs = fsecs(eval_libc_speed, &speed_params);
+		libc_stats[i].secs = replay_secs(eval_libc_speed, 
+						 &speed_params);
 	    }
 	    free_trace(trace);
 	}
@@ -269,7 +425,7 @@ int main(int argc, char **argv)
 	/* Display the libc results in a compact table */
 	if (verbose) {
 	    printf("\nResults for libc malloc:\n");
-	    printresults(num_tracefiles, libc_stats);
+	    printresults(num_tracefiles, libc_stats, 0);
 	}
     }
 
@@ -288,21 +444,51 @@ int main(int argc, char **argv)
     mem_init(); 
 
     /* Evaluate student's mm malloc package using the K-best scheme */
+    speed_params.snap_op = -1;
+    speed_params.lat = NULL;
     for (i=0; i < num_tracefiles; i++) {
 	trace = read_trace(tracedir, tracefiles[i]);
-	mm_stats[i].ops = trace->num_ops;
+	mm_stats[i].ops = trace->num_reqs;
 	if (verbose > 1)
 	    printf("Checking mm_malloc for correctness, ");
 	mm_stats[i].valid = eval_mm_valid(trace, i, &ranges);
 	if (mm_stats[i].valid) {
 	    if (verbose > 1)
 		printf("efficiency, ");
-	    mm_stats[i].util = eval_mm_util(trace, i, &ranges);
+	    if (sample_ops > 0)
+		timeline = open_timeline(tracefiles[i]);
+	    mm_stats[i].util = eval_mm_util(trace, i, &ranges, 
+					    frag_mode ? mm_stats[i].frag : NULL,
+					    foot_mode ? mm_stats[i].foot : NULL);
+	    if (timeline != NULL) {
+		fclose(timeline);
+		timeline = NULL;
+	    }
 	    speed_params.trace = trace;
 	    speed_params.ranges = ranges;
 	    if (verbose > 1)
 		printf("and performance.\n");
-	    mm_stats[i].secs = fsecs(eval_mm_speed, &speed_params);
+	    mm_stats[i].runs = calloc(reps, sizeof(double));
+	    if (mm_stats[i].runs == NULL)
+		unix_error("runs calloc in main failed");
+	    for (j = 0; j < reps; j++) {
+		mm_stats[i].runs[j] = replay_secs(eval_mm_speed, &speed_params);
+		mm_stats[i].secs += mm_stats[i].runs[j] / reps;
+	    }
+
+	    /* Then replay it once more, timing each request */
+	    if (lat_mode) {
+		mm_stats[i].lat = calloc(NUM_OP_TYPES, sizeof(lat_hist_t));
+		if (mm_stats[i].lat == NULL)
+		    unix_error("lat calloc in main failed");
+		if (trace->stream != NULL)
+		    rewind_trace(trace);
+		speed_params.lat = mm_stats[i].lat;
+		eval_mm_speed(&speed_params);
+		speed_params.lat = NULL;
+	    }
+	    if (perf_mode)
+		count_events(&speed_params, mm_stats[i].perf);
 	}
 	free_trace(trace);
     }
@@ -310,9 +496,26 @@ int main(int argc, char **argv)
     /* Display the mm results in a compact table */
     if (verbose) {
 	printf("\nResults for mm malloc:\n");
-	printresults(num_tracefiles, mm_stats);
+	printresults(num_tracefiles, mm_stats, 1);
+	printf("\n");
+    }
+    if (lat_mode) {
+	lat_failures = printlatency(num_tracefiles, mm_stats);
+	printf("\n");
+    }
+    if (reps > 1 && errors == 0) {
+	printruns(num_tracefiles, mm_stats);
 	printf("\n");
     }
+    if (perf_mode) {
+	printcounters(num_tracefiles, mm_stats);
+	printf("\n");
+	perf_close();
+    }
+
+    /* Optionally see how the heap ages when it is never reset */
+    if (age_passes > 0 && errors == 0)
+	age_heap(tracefiles, num_tracefiles, age_passes);
 
     /* 
      * Accumulate the aggregate statistics for the student's mm package 
@@ -357,11 +560,22 @@ int main(int argc, char **argv)
 	printf("Terminated with %d errors\n", errors);
     }
 
+    /* trace:<n>:<file>:<util>:<ops>:<Kops> for every run */
+    for (i = 0; run_lines && errors == 0 && i < num_tracefiles; i++)
+	for (j = 0; j < reps; j++)
+	    printf("trace:%d:%s:%.4f:%.0f:%.1f\n", i, tracefiles[i],
+		   mm_stats[i].util, mm_stats[i].ops,
+		   mm_stats[i].ops / 1e3 / mm_stats[i].runs[j]);
+
     if (autograder) {
 	printf("correct:%d\n", numcorrect);
 	printf("perfidx:%.0f\n", perfindex);
     }
 
+    if (lat_failures > 0) {
+	printf("Exceeded the latency limits %d times\n", lat_failures);
+	exit(1);
+    }
     exit(0);
 }
 
@@ -375,10 +589,12 @@ int main(int argc, char **argv)
 /*
  * add_range - As directed by request opnum in trace tracenum,
  *     we've just called the student's mm_malloc to allocate a block of 
- *     size bytes at addr lo. After checking the block for correctness,
+ *     size bytes at addr lo, aligned to align bytes (or ALIGNMENT,
+ *     if that is more). After checking the
+ *     block for correctness,
  *     we create a range struct for this block and add it to the range list. 
  */
-static int add_range(range_t **ranges, char *lo, int size, 
+static int add_range(range_t **ranges, char *lo, int size, int align,
 		     int tracenum, int opnum)
 {
     char *hi = lo + size - 1;
@@ -386,11 +602,13 @@ static int add_range(range_t **ranges, char *lo, int size,
     char msg[MAXLINE];
 
     assert(size > 0);
+    if (align < ALIGNMENT)
+	align = ALIGNMENT;
 
-    /* Payload addresses must be ALIGNMENT-byte aligned */
-    if (!IS_ALIGNED(lo)) {
+    /* Payload addresses must be ALIGNMENT-byte aligned, or more if asked */
+    if (!IS_ALIGNED(lo, align)) {
 	sprintf(msg, "Payload address (%p) not aligned to %d bytes", 
-		lo, ALIGNMENT);
+		lo, align);
         malloc_error(tracenum, opnum, msg);
         return 0;
     }
@@ -448,6 +666,29 @@ static void remove_range(range_t **ranges, char *lo)
     }
 }
 
+/*
+ * usable_extent - Return the extent of the block at p to record in the
+ *     range list. For mm blocks this is all of mm_usable_size(), so any
+ *     slack that overlaps another block is caught too. Returns 0 if the
+ *     usable size doesn't cover the request.
+ */
+static int usable_extent(char *p, int size, int tracenum, int opnum)
+{
+    size_t usable;
+    char msg[MAXLINE];
+
+    if (region_mode)
+	return size;
+
+    if ((usable = mm_usable_size(p)) < (size_t)size) {
+	sprintf(msg, "mm_usable_size (%u) smaller than the request (%d)",
+		(unsigned)usable, size);
+	malloc_error(tracenum, opnum, msg);
+	return 0;
+    }
+    return (int)usable;
+}
+
 /*
  * clear_ranges - free all of the range records for a trace 
  */
@@ -473,13 +714,8 @@ static void clear_ranges(range_t **ranges)
  */
 static trace_t *read_trace(char *tracedir, char *filename)
 {
-    FILE *tracefile;
     trace_t *trace;
-    char type[MAXLINE];
     char path[MAXLINE];
-    unsigned index, size;
-    unsigned max_index = 0;
-    unsigned op_index;
 
     if (verbose > 1)
 	printf("Reading tracefile: %s\n", filename);
@@ -488,22 +724,26 @@ static trace_t *read_trace(char *tracedir, char *filename)
     if ((trace = (trace_t *) malloc(sizeof(trace_t))) == NULL)
 	unix_error("malloc 1 failed in read_trance");
 	
-    /* Read the trace file header */
+    /* Load the trace file, or start streaming it */
     strcpy(path, tracedir);
     strcat(path, filename);
-    if ((tracefile = fopen(path, "r")) == NULL) {
-	sprintf(msg, "Could not open %s in read_trace", path);
-	unix_error(msg);
-    }
-    fscanf(tracefile, "%d", &(trace->sugg_heapsize)); /* not used */
-    fscanf(tracefile, "%d", &(trace->num_ids));     
-    fscanf(tracefile, "%d", &(trace->num_ops));     
-    fscanf(tracefile, "%d", &(trace->weight));        /* not used */
-    
-    /* We'll store each request line in the trace in this array */
-    if ((trace->ops = 
-	 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
-	unix_error("malloc 2 failed in read_trace");
+    trace->stream = NULL;
+    if (stream_mode) {
+	memset(&trace->file, 0, sizeof(trace->file));
+	if ((trace->stream = trace_stream_open(path, &trace->file.hdr)) == NULL)
+	    exit(1);
+    }
+    else if (trace_load(path, &trace->file) < 0)
+	exit(1);
+    trace->sugg_heapsize = trace->file.hdr.sugg_heapsize; /* not used */
+    trace->num_ids = trace->file.hdr.num_ids;
+    trace->num_ops = trace->file.hdr.num_ops;
+    trace->num_reqs = trace->file.hdr.num_reqs;
+    trace->weight = trace->file.hdr.weight;               /* not used */
+    trace->ops = trace->file.ops;
+    trace->win_start = 0;
+    trace->win_end = stream_mode ? 0 : trace->num_ops;
+    trace->stall_secs = 0;
 
     /* We'll keep an array of pointers to the allocated blocks here... */
     if ((trace->blocks = 
@@ -515,57 +755,77 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
 	unix_error("malloc 4 failed in read_trace");
     
-    /* read every request line in the trace file */
-    index = 0;
-    op_index = 0;
-    while (fscanf(tracefile, "%s", type) != EOF) {
-	switch(type[0]) {
-	case 'a':
-	    fscanf(tracefile, "%u %u", &index, &size);
-	    trace->ops[op_index].type = ALLOC;
-	    trace->ops[op_index].index = index;
-	    trace->ops[op_index].size = size;
-	    max_index = (index > max_index) ? index : max_index;
-	    break;
-	case 'r':
-	    fscanf(tracefile, "%u %u", &index, &size);
-	    trace->ops[op_index].type = REALLOC;
-	    trace->ops[op_index].index = index;
-	    trace->ops[op_index].size = size;
-	    max_index = (index > max_index) ? index : max_index;
-	    break;
-	case 'f':
-	    fscanf(tracefile, "%ud", &index);
-	    trace->ops[op_index].type = FREE;
-	    trace->ops[op_index].index = index;
-	    break;
-	default:
-	    printf("Bogus type character (%c) in tracefile %s\n", 
-		   type[0], path);
-	    exit(1);
-	}
-	op_index++;
-	
-    }
-    fclose(tracefile);
-    assert(max_index == trace->num_ids - 1);
-    assert(trace->num_ops == op_index);
-    
     return trace;
 }
 
 /*
- * free_trace - Free the trace record and the three arrays it points
- *              to, all of which were allocated in read_trace().
+ * free_trace - Free the trace record, its requests and the two arrays
+ *              it points to, all of which were set up in read_trace().
  */
 void free_trace(trace_t *trace)
 {
-    free(trace->ops);         /* free the three arrays... */
-    free(trace->blocks);      
+    if (trace->stream != NULL)  /* release the requests... */
+	trace_stream_close(trace->stream);
+    else
+	trace_unload(&trace->file);
+    free(trace->blocks);        /* ...the two arrays... */
     free(trace->block_sizes);
     free(trace);              /* and the trace record itself... */
 }
 
+/*
+ * load_window - move a streamed trace to the window holding request i:
+ *     the next window, or the first after a rewind
+ */
+static traceop_t *load_window(trace_t *trace, int i)
+{
+    int n;
+
+    if (i < trace->win_start)
+	rewind_trace(trace);
+    while (i >= trace->win_end) {
+	if ((n = trace_stream_next(trace->stream, &trace->ops)) <= 0)
+	    app_error("streamed trace ended early");
+	trace->win_start = trace->win_end;
+	trace->win_end += n;
+    }
+    return &trace->ops[i - trace->win_start];
+}
+
+/*
+ * rewind_trace - start a streamed trace over from its first request
+ */
+static void rewind_trace(trace_t *trace)
+{
+    if (trace_stream_rewind(trace->stream) < 0)
+	exit(1);
+    trace->win_start = trace->win_end = 0;
+}
+
+/*
+ * replay_secs - the running time of f on the trace in params. A
+ *     streamed trace can't be replayed over and over as fsecs() does,
+ *     so it is timed over one run, less the time spent waiting for
+ *     windows to be decoded.
+ */
+static double replay_secs(fsecs_test_funct f, speed_t *params)
+{
+    trace_t *trace = params->trace;
+    double stall, secs;
+
+    if (trace->stream == NULL)
+	return fsecs(f, params);
+
+    rewind_trace(trace);
+    stall = trace_stream_stall(trace->stream);
+    secs = fsecs_once(f, params);
+    trace->stall_secs = trace_stream_stall(trace->stream) - stall;
+    if (verbose > 1)
+	printf("Decode stalls: %.6f of %.6f secs, not counted.\n",
+	       trace->stall_secs, secs);
+    return secs - trace->stall_secs;
+}
+
 /**********************************************************************
  * The following functions evaluate the correctness, space utilization,
  * and throughput of the libc and mm malloc packages.
@@ -576,13 +836,8 @@ void free_trace(trace_t *trace)
  */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges) 
 {
-    int i, j;
-    int index;
-    int size;
-    int oldsize;
-    char *newp;
-    char *oldp;
-    char *p;
+    mm_region_t *region = NULL;
+    int valid;
     
     /* Reset the heap and free any records in the range list */
     mem_reset_brk();
@@ -593,18 +848,49 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	malloc_error(tracenum, 0, "mm_init failed.");
 	return 0;
     }
+    if (region_mode && 
+	(region = mm_region_create(mm_default_heap())) == NULL) {
+	malloc_error(tracenum, 0, "mm_region_create failed.");
+	return 0;
+    }
+
+    valid = check_requests(trace, tracenum, ranges, region);
+    if (region != NULL)
+	mm_region_destroy(region);
+    return valid;
+}
+
+/*
+ * check_requests - Replay the trace for eval_mm_valid, through region
+ *     if it isn't NULL, and check the result of every request
+ */
+static int check_requests(trace_t *trace, int tracenum, range_t **ranges,
+			  mm_region_t *region)
+{
+    int i, j;
+    int index;
+    int size;
+    int oldsize;
+    int count;
+    int extent;
+    char *newp;
+    char *oldp;
+    char *p;
+    traceop_t *op;
 
     /* Interpret each operation in the trace in order */
     for (i = 0;  i < trace->num_ops;  i++) {
-	index = trace->ops[i].index;
-	size = trace->ops[i].size;
+	op = trace_op(trace, i);
+	index = op->index;
+	size = op->size;
 
-        switch (trace->ops[i].type) {
+        switch (op->type) {
 
         case ALLOC: /* mm_malloc */
 
 	    /* Call the student's malloc */
-	    if ((p = mm_malloc(size)) == NULL) {
+	    p = block_alloc(region, op->align, size);
+	    if (p == NULL) {
 		malloc_error(tracenum, i, "mm_malloc failed.");
 		return 0;
 	    }
@@ -614,7 +900,9 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	     * to the range list if OK. The block must be  be aligned properly,
 	     * and must not overlap any currently allocated block. 
 	     */ 
-	    if (add_range(ranges, p, size, tracenum, i) == 0)
+	    if ((extent = usable_extent(p, size, tracenum, i)) == 0 ||
+		add_range(ranges, p, extent, op->align, 
+			  tracenum, i) == 0)
 		return 0;
 	    
 	    /* ADDED: cgw
@@ -629,11 +917,41 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    trace->block_sizes[index] = size;
 	    break;
 
+        case CALLOC: /* mm_calloc */
+
+	    p = block_calloc(region, op->nmemb, size);
+	    if (p == NULL) {
+		malloc_error(tracenum, i, "mm_calloc failed.");
+		return 0;
+	    }
+	    if ((extent = usable_extent(p, size, tracenum, i)) == 0 ||
+		add_range(ranges, p, extent, ALIGNMENT, tracenum, i) == 0)
+		return 0;
+
+	    /* The whole payload must read as zero before we fill it */
+	    for (j = 0; j < size; j++) {
+		if (p[j] != 0) {
+		    malloc_error(tracenum, i, "mm_calloc returned a block "
+				 "that is not zeroed");
+		    return 0;
+		}
+	    }
+	    memset(p, index & 0xFF, size);
+
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
         case REALLOC: /* mm_realloc */
 	    
 	    /* Call the student's realloc */
 	    oldp = trace->blocks[index];
-	    if ((newp = mm_realloc(oldp, size)) == NULL) {
+	    if (region_mode)
+		newp = mm_region_realloc(region, oldp, 
+					 trace->block_sizes[index], size);
+	    else
+		newp = mm_realloc(oldp, size);
+	    if (newp == NULL) {
 		malloc_error(tracenum, i, "mm_realloc failed.");
 		return 0;
 	    }
@@ -642,7 +960,8 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    remove_range(ranges, oldp);
 	    
 	    /* Check new block for correctness and add it to range list */
-	    if (add_range(ranges, newp, size, tracenum, i) == 0)
+	    if ((extent = usable_extent(newp, size, tracenum, i)) == 0 ||
+		add_range(ranges, newp, extent, ALIGNMENT, tracenum, i) == 0)
 		return 0;
 	    
 	    /* ADDED: cgw
@@ -653,7 +972,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    oldsize = trace->block_sizes[index];
 	    if (size < oldsize) oldsize = size;
 	    for (j = 0; j < oldsize; j++) {
-	      if (newp[j] != (index & 0xFF)) {
+	      if ((unsigned char)newp[j] != (index & 0xFF)) {
 		malloc_error(tracenum, i, "mm_realloc did not preserve the "
 			     "data from old block");
 		return 0;
@@ -671,7 +990,45 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    /* Remove region from list and call student's free function */
 	    p = trace->blocks[index];
 	    remove_range(ranges, p);
-	    mm_free(p);
+	    if (!region_mode)
+		mm_free_sized(p, trace->block_sizes[index]);
+	    break;
+
+        case RELEASE: /* end of request scope */
+
+	    /* Every block allocated in the scope must be dead by now */
+	    if (*ranges != NULL) {
+		malloc_error(tracenum, i, "blocks still live at end of scope");
+		return 0;
+	    }
+	    if (region_mode)
+		mm_region_reset(region);
+	    break;
+
+        case ALLOC_BATCH: /* mm_malloc_batch */
+	    count = op->count;
+	    if (batch_alloc(region, size, count, &trace->blocks[index]) == 0) {
+		malloc_error(tracenum, i, "mm_malloc_batch failed.");
+		return 0;
+	    }
+
+	    /* Check, fill and remember every block, as for mm_malloc */
+	    for (j = 0; j < count; j++) {
+		p = trace->blocks[index + j];
+		if ((extent = usable_extent(p, size, tracenum, i)) == 0 ||
+		    add_range(ranges, p, extent, ALIGNMENT, tracenum, i) == 0)
+		    return 0;
+		memset(p, (index + j) & 0xFF, size);
+		trace->block_sizes[index + j] = size;
+	    }
+	    break;
+
+        case FREE_BATCH: /* mm_free_batch */
+	    count = op->count;
+	    for (j = 0; j < count; j++)
+		remove_range(ranges, trace->blocks[index + j]);
+	    if (!region_mode)
+		batch_free(count, &trace->blocks[index]);
 	    break;
 
 	default:
@@ -694,35 +1051,80 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
  *   doesn't allow the students to decrement the brk pointer, so brk
  *   is always the high water mark of the heap. 
  *   
+ *   If frag is not NULL, the rest of the heap at the peak is broken
+ *   down into it, as fractions of the heap; see frag_breakdown().
+ *
+ *   The peak alone can't tell a heap that holds its memory for the
+ *   whole trace from one that gives it back, so if foot is not NULL,
+ *   the live payload, the heap size and the heap's resident pages are
+ *   summed over the requests (integrated over request count), and
+ *   foot gets the live sum over the heap sum (time-weighted util), the
+ *   live sum over the resident sum, which credits pages handed back
+ *   by mem_zero() or any other trimming, and the peak resident bytes.
+ *   The heap's pages are purged first so that none are left over from
+ *   earlier runs, and each new payload is touched as a program would
+ *   use it. Resident pages are counted every RSS_SAMPLE requests.
  */
-static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
+static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges,
+			   double *frag, double *foot)
 {   
-    int i;
+    int i, j;
     int index;
     int size, newsize, oldsize;
+    int count;
     int max_total_size = 0;
     int total_size = 0;
+    int bin_peak = 0;
+    int peak_op = -1;
+    char *live = NULL;  /* with frag: 1 if live, 2 if last realloc'd */
+    double live_sum = 0, heap_sum = 0, rss_sum = 0; /* with foot */
+    size_t rss = 0, rss_peak = 0;
     char *p;
     char *newp, *oldp;
+    traceop_t *op;
+    mm_region_t *region = NULL;
+
+    /* Find the peak first, to break down the heap when we get there */
+    if (frag != NULL) {
+	peak_payload(trace, &peak_op);
+	if ((live = calloc(trace->num_ids, 1)) == NULL)
+	    unix_error("calloc failed in eval_mm_util");
+    }
 
     /* initialize the heap and the mm malloc package */
-    mem_reset_brk();
+    if (foot != NULL)
+	mem_purge();
+    else
+	mem_reset_brk();
     if (mm_init() < 0)
 	app_error("mm_init failed in eval_mm_util");
+    if (region_mode && 
+	(region = mm_region_create(mm_default_heap())) == NULL)
+	app_error("mm_region_create failed in eval_mm_util");
 
     for (i = 0;  i < trace->num_ops;  i++) {
-        switch (trace->ops[i].type) {
+	op = trace_op(trace, i);
+        switch (op->type) {
 
         case ALLOC: /* mm_alloc */
-	    index = trace->ops[i].index;
-	    size = trace->ops[i].size;
-
-	    if ((p = mm_malloc(size)) == NULL) 
+        case CALLOC: /* mm_calloc */
+	    index = op->index;
+	    size = op->size;
+
+	    if (op->type == CALLOC)
+		p = block_calloc(region, op->nmemb, size);
+	    else
+		p = block_alloc(region, op->align, size);
+	    if (p == NULL) 
 		app_error("mm_malloc failed in eval_mm_util");
 	    
 	    /* Remember region and size */
 	    trace->blocks[index] = p;
 	    trace->block_sizes[index] = size;
+	    if (live)
+		live[index] = 1;
+	    if (foot)
+		touch_payload(p, size);
 	    
 	    /* Keep track of current total size
 	     * of all allocated blocks */
@@ -734,17 +1136,25 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    break;
 
 	case REALLOC: /* mm_realloc */
-	    index = trace->ops[i].index;
-	    newsize = trace->ops[i].size;
+	    index = op->index;
+	    newsize = op->size;
 	    oldsize = trace->block_sizes[index];
 
 	    oldp = trace->blocks[index];
-	    if ((newp = mm_realloc(oldp,newsize)) == NULL)
+	    if (region_mode)
+		newp = mm_region_realloc(region, oldp, oldsize, newsize);
+	    else
+		newp = mm_realloc(oldp,newsize);
+	    if (newp == NULL)
 		app_error("mm_realloc failed in eval_mm_util");
 
 	    /* Remember region and size */
 	    trace->blocks[index] = newp;
 	    trace->block_sizes[index] = newsize;
+	    if (live)
+		live[index] = 2;
+	    if (foot)
+		touch_payload(newp, newsize);
 	    
 	    /* Keep track of current total size
 	     * of all allocated blocks */
@@ -756,11 +1166,14 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    break;
 
         case FREE: /* mm_free */
-	    index = trace->ops[i].index;
+	    index = op->index;
 	    size = trace->block_sizes[index];
 	    p = trace->blocks[index];
 	    
-	    mm_free(p);
+	    if (!region_mode)
+		mm_free(p);
+	    if (live)
+		live[index] = 0;
 	    
 	    /* Keep track of current total size
 	     * of all allocated blocks */
@@ -768,16 +1181,100 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    
 	    break;
 
+        case RELEASE: /* end of request scope */
+	    if (region_mode)
+		mm_region_reset(region);
+	    break;
+
+        case ALLOC_BATCH: /* mm_malloc_batch */
+	    index = op->index;
+	    size = op->size;
+	    count = op->count;
+
+	    if (batch_alloc(region, size, count, &trace->blocks[index]) == 0)
+		app_error("mm_malloc_batch failed in eval_mm_util");
+	    for (j = 0; j < count; j++)
+		trace->block_sizes[index + j] = size;
+	    if (live)
+		memset(live + index, 1, count);
+	    for (j = 0; foot && j < count; j++)
+		touch_payload(trace->blocks[index + j], size);
+
+	    total_size += size * count;
+	    max_total_size = (total_size > max_total_size) ?
+		total_size : max_total_size;
+	    break;
+
+        case FREE_BATCH: /* mm_free_batch */
+	    index = op->index;
+	    count = op->count;
+
+	    if (!region_mode)
+		batch_free(count, &trace->blocks[index]);
+	    for (j = 0; j < count; j++)
+		total_size -= trace->block_sizes[index + j];
+	    if (live)
+		memset(live + index, 0, count);
+	    break;
+
 	default:
 	    app_error("Nonexistent request type in eval_mm_util");
 
         }
+
+	if (i == peak_op)
+	    frag_breakdown(trace, live, frag);
+
+	/* Sample the heap at the end of every bin of sample_ops requests */
+	if (timeline != NULL) {
+	    bin_peak = (total_size > bin_peak) ? total_size : bin_peak;
+	    if ((i + 1) % sample_ops == 0 || i == trace->num_ops - 1) {
+		sample_heap(i + 1, total_size, bin_peak);
+		bin_peak = total_size;
+	    }
+	}
+
+	/* Integrate the footprint over the requests */
+	if (foot != NULL) {
+	    if (i % RSS_SAMPLE == 0 || i == trace->num_ops - 1) {
+		rss = mem_resident();
+		rss_peak = (rss > rss_peak) ? rss : rss_peak;
+	    }
+	    live_sum += total_size;
+	    heap_sum += mem_heapsize();
+	    rss_sum += rss;
+	}
     }
 
+    if (foot != NULL) {
+	foot[0] = (heap_sum > 0) ? live_sum / heap_sum : 0;
+	foot[1] = (rss_sum > 0) ? live_sum / rss_sum : 0;
+	foot[2] = rss_peak;
+    }
+    free(live);
+    if (region != NULL)
+	mm_region_destroy(region);
     return ((double)max_total_size / (double)mem_heapsize());
 }
 
 
+/*
+ * touch_payload - Bring every page of a payload into memory, as the
+ *    program that owns it would, without changing its contents
+ */
+static void touch_payload(char *p, int size)
+{
+    volatile char *v = p;
+    int pagesize = mem_pagesize();
+    int k;
+
+    for (k = 0; k < size; k += pagesize - (int)((size_t)(v + k) % pagesize))
+	v[k] = v[k];
+    if (size > 0)
+	v[size - 1] = v[size - 1];
+}
+
+
 /*
  * eval_mm_speed - This is the function that is used by fcyc()
  *    to measure the running time of the mm malloc package.
@@ -786,43 +1283,330 @@ static void eval_mm_speed(void *ptr)
 {
     int i, index, size, newsize;
     char *p, *newp, *oldp, *block;
-    trace_t *trace = ((speed_t *)ptr)->trace;
-
-    /* Reset the heap and initialize the mm package */
-    mem_reset_brk();
-    if (mm_init() < 0) 
-	app_error("mm_init failed in eval_mm_speed");
+    speed_t *params = (speed_t *)ptr;
+    trace_t *trace = params->trace;
+    traceop_t *op;
+    mm_region_t *region = NULL;
+    unsigned long long t0 = 0;
+
+    /* Reset the heap and initialize the mm package, unless aging it */
+    if (!aging) {
+	mem_reset_brk();
+	if (mm_init() < 0) 
+	    app_error("mm_init failed in eval_mm_speed");
+    }
+    if (region_mode && 
+	(region = mm_region_create(mm_default_heap())) == NULL)
+	app_error("mm_region_create failed in eval_mm_speed");
 
-    /* Interpret each trace request */
-    for (i = 0;  i < trace->num_ops;  i++)
-        switch (trace->ops[i].type) {
+    /* Interpret each trace request, timing it if asked to */
+    for (i = 0;  i < trace->num_ops;  i++) {
+	op = trace_op(trace, i);
+	if (params->lat != NULL)
+	    t0 = lat_ticks();
+        switch (op->type) {
 
         case ALLOC: /* mm_malloc */
-            index = trace->ops[i].index;
-            size = trace->ops[i].size;
-            if ((p = mm_malloc(size)) == NULL)
+            index = op->index;
+            size = op->size;
+            p = block_alloc(region, op->align, size);
+            if (p == NULL)
 		app_error("mm_malloc error in eval_mm_speed");
             trace->blocks[index] = p;
+            trace->block_sizes[index] = size;
+            break;
+
+        case CALLOC: /* mm_calloc */
+            index = op->index;
+            size = op->size;
+            p = block_calloc(region, op->nmemb, size);
+            if (p == NULL)
+		app_error("mm_calloc error in eval_mm_speed");
+            trace->blocks[index] = p;
+            trace->block_sizes[index] = size;
             break;
 
 	case REALLOC: /* mm_realloc */
-	    index = trace->ops[i].index;
-            newsize = trace->ops[i].size;
+	    index = op->index;
+            newsize = op->size;
 	    oldp = trace->blocks[index];
-            if ((newp = mm_realloc(oldp,newsize)) == NULL)
+	    if (region_mode)
+		newp = mm_region_realloc(region, oldp, 
+					 trace->block_sizes[index], newsize);
+	    else
+		newp = mm_realloc(oldp,newsize);
+            if (newp == NULL)
 		app_error("mm_realloc error in eval_mm_speed");
             trace->blocks[index] = newp;
+            trace->block_sizes[index] = newsize;
             break;
 
-        case FREE: /* mm_free */
-            index = trace->ops[i].index;
+        case FREE: /* mm_free_sized, as C++ sized delete calls it */
+            index = op->index;
             block = trace->blocks[index];
-            mm_free(block);
+            if (!region_mode)
+		mm_free_sized(block, trace->block_sizes[index]);
+            break;
+
+        case RELEASE: /* end of request scope */
+            if (region_mode)
+		mm_region_reset(region);
+            break;
+
+        case ALLOC_BATCH: /* mm_malloc_batch */
+            index = op->index;
+            size = op->size;
+            if (batch_alloc(region, size, op->count, 
+			    &trace->blocks[index]) == 0)
+		app_error("mm_malloc_batch error in eval_mm_speed");
+            break;
+
+        case FREE_BATCH: /* mm_free_batch */
+            if (!region_mode)
+		batch_free(op->count, 
+			   &trace->blocks[op->index]);
             break;
 
 	default:
 	    app_error("Nonexistent request type in eval_mm_valid");
         }
+	if (params->lat != NULL)
+	    lat_record(&params->lat[op->type], lat_ticks() - t0);
+	if (i == params->snap_op)
+	    mm_heap_stats(mm_default_heap(), params->snap);
+    }
+    if (region != NULL)
+	mm_region_destroy(region);
+}
+
+/*
+ * count_events - Count hardware events over PERF_RUNS replays of the
+ *     trace, keeping the fewest of each, as fsecs() keeps the fastest
+ */
+static void count_events(speed_t *params, double *counts)
+{
+    double c[PERF_NUM];
+    int r, k;
+
+    for (r = 0; r < PERF_RUNS; r++) {
+	if (params->trace->stream != NULL)
+	    rewind_trace(params->trace);
+	perf_start();
+	eval_mm_speed(params);
+	perf_stop(c);
+	for (k = 0; k < PERF_NUM; k++)
+	    if (r == 0 || c[k] < counts[k])
+		counts[k] = c[k];
+    }
+}
+
+/*
+ * peak_payload - The most payload bytes the trace ever has allocated at
+ *     once, and the request at which it first gets there
+ */
+static int peak_payload(trace_t *trace, int *peak_op)
+{
+    int i, j, total = 0, peak = 0;
+    traceop_t *op;
+
+    *peak_op = 0;
+    for (i = 0; i < trace->num_ops; i++) {
+	op = trace_op(trace, i);
+	switch (op->type) {
+	case ALLOC:
+	case CALLOC:
+	    trace->block_sizes[op->index] = op->size;
+	    total += op->size;
+	    break;
+	case REALLOC:
+	    total += op->size - trace->block_sizes[op->index];
+	    trace->block_sizes[op->index] = op->size;
+	    break;
+	case FREE:
+	    total -= trace->block_sizes[op->index];
+	    break;
+	case ALLOC_BATCH:
+	    for (j = 0; j < op->count; j++)
+		trace->block_sizes[op->index + j] = op->size;
+	    total += op->size * op->count;
+	    break;
+	case FREE_BATCH:
+	    for (j = 0; j < op->count; j++)
+		total -= trace->block_sizes[op->index + j];
+	    break;
+	}
+	if (total > peak) {
+	    peak = total;
+	    *peak_op = i;
+	}
+    }
+    return peak;
+}
+
+/*
+ * Totals of a heap walk, for frag_breakdown()
+ */
+typedef struct {
+    size_t alloc_blocks;  /* allocated blocks... */
+    size_t alloc_bytes;   /* ...and their total size */
+    size_t free_bytes;    /* total size of the free blocks */
+} walk_t;
+
+static void walk_block(void *bp, size_t size, int alloc, void *arg)
+{
+    walk_t *w = (walk_t *)arg;
+
+    if (alloc) {
+	w->alloc_blocks++;
+	w->alloc_bytes += size;
+    } else
+	w->free_bytes += size;
+}
+
+/*
+ * frag_breakdown - Split the part of the heap that isn't live payload
+ *     into four fractions of the heap:
+ *       frag[0]  metadata: block headers and footers, and the heap's
+ *                prologue and epilogue
+ *       frag[1]  internal slack: payloads rounded up to the alignment
+ *                and minimum block, and remainders too small to split
+ *                off (or blocks, such as region chunks, that the trace
+ *                doesn't know about)
+ *       frag[2]  realloc reserve: room a block last resized by realloc
+ *                has beyond the block a malloc of its size would get,
+ *                which mm_realloc keeps so the block can grow in place
+ *                (always 0 under -R)
+ *       frag[3]  free blocks
+ *     live says which ids are allocated and which were realloc'd.
+ */
+static void frag_breakdown(trace_t *trace, char *live, double *frag)
+{
+    walk_t w = {0, 0, 0};
+    size_t heap = mem_heapsize(), payload = 0, reserve = 0, block, min;
+    int i;
+
+    for (i = 0; i < trace->num_ids; i++) {
+	if (!live[i])
+	    continue;
+	payload += trace->block_sizes[i];
+	/* Region objects have no block of their own to measure */
+	if (live[i] == 2 && !region_mode) {
+	    block = mm_usable_size(trace->blocks[i]) + MM_OVERHEAD;
+	    min = MM_BLOCK_SIZE(trace->block_sizes[i]);
+	    reserve += (block > min) ? block - min : 0;
+	}
+    }
+    mm_heap_walk(mm_default_heap(), walk_block, &w);
+
+    frag[0] = (double)(w.alloc_blocks * MM_OVERHEAD +
+		       heap - w.alloc_bytes - w.free_bytes) / heap;
+    frag[1] = ((double)w.alloc_bytes - w.alloc_blocks * MM_OVERHEAD -
+	       payload - reserve) / heap;
+    frag[2] = (double)reserve / heap;
+    frag[3] = (double)w.free_bytes / heap;
+}
+
+/*
+ * open_timeline - Create the timeline CSV for a trace: the trace's file
+ *     name without its directory and suffix, plus "-timeline.csv", in
+ *     the current directory
+ */
+static FILE *open_timeline(char *tracefile)
+{
+    char path[MAXLINE];
+    char *base, *dot;
+    FILE *fp;
+
+    base = (base = strrchr(tracefile, '/')) ? base + 1 : tracefile;
+    strncpy(path, base, MAXLINE - sizeof("-timeline.csv"));
+    path[MAXLINE - sizeof("-timeline.csv")] = '\0';
+    if ((dot = strrchr(path, '.')) != NULL)
+	*dot = '\0';
+    strcat(path, "-timeline.csv");
+    if ((fp = fopen(path, "w")) == NULL)
+	unix_error(path);
+    fprintf(fp, "ops,live_bytes,bin_peak_bytes,heap_bytes,free_bytes,"
+	    "largest_free,free_blocks,ext_frag\n");
+    if (verbose > 1)
+	printf("sampling to %s, ", path);
+    return fp;
+}
+
+/*
+ * sample_heap - Write one timeline row: the live payload now and its
+ *     peak over the bin just ended, the heap size, the free-list
+ *     state, and the external fragmentation index, 1 - (largest free
+ *     block / free bytes), which is 0 when all the free space is in one
+ *     block and nears 1 as it splinters
+ */
+static void sample_heap(int opnum, int live, int bin_peak)
+{
+    mm_heap_stats_t st;
+
+    mm_heap_stats(mm_default_heap(), &st);
+    fprintf(timeline, "%d,%d,%d,%lu,%lu,%lu,%lu,%.4f\n", opnum, live,
+	    bin_peak, (unsigned long)st.heap_bytes,
+	    (unsigned long)st.free_bytes, (unsigned long)st.largest_free,
+	    (unsigned long)st.free_blocks,
+	    st.free_bytes ? 1.0 - (double)st.largest_free / st.free_bytes : 0);
+}
+
+/*
+ * age_heap - Replay the traces back to back, passes times over, on one
+ *     heap that is never reset, as a long-running program would use
+ *     it. After each replay, print the heap size, the utilization (the
+ *     trace's peak payload over the heap size), the free-list state at
+ *     that peak, and the throughput of the replay. Blocks a trace never
+ *     frees stay allocated for the rest of the run.
+ */
+static void age_heap(char **tracefiles, int n, int passes)
+{
+    trace_t **traces;
+    int *peak, *peak_op;
+    speed_t params;
+    mm_heap_stats_t snap;
+    double secs;
+    int pass, i;
+
+    if ((traces = malloc(n * sizeof(trace_t *))) == NULL ||
+	(peak = malloc(n * sizeof(int))) == NULL ||
+	(peak_op = malloc(n * sizeof(int))) == NULL)
+	unix_error("malloc failed in age_heap");
+    for (i = 0; i < n; i++) {
+	traces[i] = read_trace(tracedir, tracefiles[i]);
+	peak[i] = peak_payload(traces[i], &peak_op[i]);
+    }
+
+    printf("Aging one heap over %d passes of %d traces:\n", passes, n);
+    printf("%4s%6s%10s%6s%8s%10s%10s%7s\n", "pass", "trace", "heap KB",
+	   "util", "free", "free KB", "big KB", "Kops");
+    mem_reset_brk();
+    if (mm_init() < 0)
+	app_error("mm_init failed in age_heap");
+    aging = 1;
+    memset(&params, 0, sizeof(params));
+    params.snap = &snap;
+    for (pass = 1; pass <= passes; pass++) {
+	for (i = 0; i < n; i++) {
+	    params.trace = traces[i];
+	    params.snap_op = peak_op[i];
+	    secs = fsecs_once(eval_mm_speed, &params);
+	    printf("%4d%6d%10.0f%5.0f%%%8lu%10.0f%10.0f%7.0f\n", pass, i,
+		   mem_heapsize() / 1024.0,
+		   100.0 * peak[i] / mem_heapsize(),
+		   (unsigned long)snap.free_blocks, snap.free_bytes / 1024.0,
+		   snap.largest_free / 1024.0,
+		   (traces[i]->num_reqs / 1e3) / secs);
+	    fflush(stdout);
+	}
+    }
+    aging = 0;
+
+    for (i = 0; i < n; i++)
+	free_trace(traces[i]);
+    free(traces);
+    free(peak);
+    free(peak_op);
 }
 
 /*
@@ -833,32 +1617,62 @@ static void eval_mm_speed(void *ptr)
  */
 static int eval_libc_valid(trace_t *trace, int tracenum)
 {
-    int i, newsize;
+    int i, j, newsize;
     char *p, *newp, *oldp;
+    traceop_t *op;
 
     for (i = 0;  i < trace->num_ops;  i++) {
-        switch (trace->ops[i].type) {
+	op = trace_op(trace, i);
+        switch (op->type) {
 
         case ALLOC: /* malloc */
-	    if ((p = malloc(trace->ops[i].size)) == NULL) {
+	    if ((p = libc_alloc(op->align, 
+				op->size)) == NULL) {
 		malloc_error(tracenum, i, "libc malloc failed");
 		unix_error("System message");
 	    }
-	    trace->blocks[trace->ops[i].index] = p;
+	    trace->blocks[op->index] = p;
+	    break;
+
+        case CALLOC: /* calloc */
+	    if ((p = calloc(op->nmemb, 
+			    op->size / op->nmemb)) == NULL) {
+		malloc_error(tracenum, i, "libc calloc failed");
+		unix_error("System message");
+	    }
+	    trace->blocks[op->index] = p;
 	    break;
 
 	case REALLOC: /* realloc */
-            newsize = trace->ops[i].size;
-	    oldp = trace->blocks[trace->ops[i].index];
+            newsize = op->size;
+	    oldp = trace->blocks[op->index];
 	    if ((newp = realloc(oldp, newsize)) == NULL) {
 		malloc_error(tracenum, i, "libc realloc failed");
 		unix_error("System message");
 	    }
-	    trace->blocks[trace->ops[i].index] = newp;
+	    trace->blocks[op->index] = newp;
 	    break;
 	    
         case FREE: /* free */
-	    free(trace->blocks[trace->ops[i].index]);
+	    free(trace->blocks[op->index]);
+	    break;
+
+        case RELEASE: /* nothing to do for libc */
+	    break;
+
+        case ALLOC_BATCH: /* malloc, one block at a time */
+	    for (j = 0; j < op->count; j++) {
+		if ((p = malloc(op->size)) == NULL) {
+		    malloc_error(tracenum, i, "libc malloc failed");
+		    unix_error("System message");
+		}
+		trace->blocks[op->index + j] = p;
+	    }
+	    break;
+
+        case FREE_BATCH: /* free, one block at a time */
+	    for (j = 0; j < op->count; j++)
+		free(trace->blocks[op->index + j]);
 	    break;
 
 	default:
@@ -876,24 +1690,35 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
  */
 static void eval_libc_speed(void *ptr)
 {
-    int i;
+    int i, j;
     int index, size, newsize;
     char *p, *newp, *oldp, *block;
     trace_t *trace = ((speed_t *)ptr)->trace;
+    traceop_t *op;
 
     for (i = 0;  i < trace->num_ops;  i++) {
-        switch (trace->ops[i].type) {
+	op = trace_op(trace, i);
+        switch (op->type) {
         case ALLOC: /* malloc */
-	    index = trace->ops[i].index;
-	    size = trace->ops[i].size;
-	    if ((p = malloc(size)) == NULL)
+	    index = op->index;
+	    size = op->size;
+	    if ((p = libc_alloc(op->align, size)) == NULL)
 		unix_error("malloc failed in eval_libc_speed");
 	    trace->blocks[index] = p;
 	    break;
 
+        case CALLOC: /* calloc */
+	    index = op->index;
+	    size = op->size;
+	    if ((p = calloc(op->nmemb, 
+			    size / op->nmemb)) == NULL)
+		unix_error("calloc failed in eval_libc_speed");
+	    trace->blocks[index] = p;
+	    break;
+
 	case REALLOC: /* realloc */
-	    index = trace->ops[i].index;
-	    newsize = trace->ops[i].size;
+	    index = op->index;
+	    newsize = op->size;
 	    oldp = trace->blocks[index];
 	    if ((newp = realloc(oldp, newsize)) == NULL)
 		unix_error("realloc failed in eval_libc_speed\n");
@@ -902,38 +1727,172 @@ static void eval_libc_speed(void *ptr)
 	    break;
 	    
         case FREE: /* free */
-	    index = trace->ops[i].index;
+	    index = op->index;
 	    block = trace->blocks[index];
 	    free(block);
 	    break;
+
+        case RELEASE: /* nothing to do for libc */
+	    break;
+
+        case ALLOC_BATCH: /* malloc, one block at a time */
+	    index = op->index;
+	    size = op->size;
+	    for (j = 0; j < op->count; j++) {
+		if ((p = malloc(size)) == NULL)
+		    unix_error("malloc failed in eval_libc_speed");
+		trace->blocks[index + j] = p;
+	    }
+	    break;
+
+        case FREE_BATCH: /* free, one block at a time */
+	    index = op->index;
+	    for (j = 0; j < op->count; j++)
+		free(trace->blocks[index + j]);
+	    break;
 	}
     }
 }
 
+/*
+ * block_alloc - Allocate one block of size bytes aligned to align
+ *    bytes, from the region with -R (rounding up inside a padded
+ *    chunk), else with mm_memalign or mm_malloc.
+ */
+static char *block_alloc(mm_region_t *region, int align, int size)
+{
+    char *p;
+
+    if (region_mode) {
+	if (align <= ALIGNMENT)
+	    return mm_region_alloc(region, size);
+	if ((p = mm_region_alloc(region, size + align - ALIGNMENT)) == NULL)
+	    return NULL;
+	return (char *)(((unsigned long)p + align - 1) & 
+			~(unsigned long)(align - 1));
+    }
+    if (align <= ALIGNMENT)
+	return mm_malloc(size);
+    return mm_memalign(align, size);
+}
+
+/*
+ * block_calloc - Allocate a zeroed array of nmemb elements, size bytes
+ *    in all, from the region with -R, else with mm_calloc.
+ */
+static char *block_calloc(mm_region_t *region, int nmemb, int size)
+{
+    char *p;
+
+    if (region_mode) {
+	if ((p = mm_region_alloc(region, size)) != NULL)
+	    memset(p, 0, size);
+	return p;
+    }
+    return mm_calloc(nmemb, size / nmemb);
+}
+
+/*
+ * libc_alloc - The libc counterpart of block_alloc
+ */
+static char *libc_alloc(int align, int size)
+{
+    void *p;
+
+    if (align <= ALIGNMENT)
+	return malloc(size);
+    if (posix_memalign(&p, align, size) != 0)
+	return NULL;
+    return p;
+}
+
+/*
+ * batch_alloc - Allocate count blocks of size bytes into blocks[],
+ *    through mm_malloc_batch, or one at a time with -b or -R.
+ *    Returns 0 if the allocation failed.
+ */
+static int batch_alloc(mm_region_t *region, int size, int count, 
+		       char **blocks)
+{
+    int j;
+
+    if (region_mode) {
+	for (j = 0; j < count; j++)
+	    if ((blocks[j] = mm_region_alloc(region, size)) == NULL)
+		return 0;
+	return 1;
+    }
+    if (batch_split) {
+	for (j = 0; j < count; j++)
+	    if ((blocks[j] = mm_malloc(size)) == NULL)
+		return 0;
+	return 1;
+    }
+    return mm_malloc_batch(size, count, (void **)blocks) == count;
+}
+
+/*
+ * batch_free - Free count blocks through mm_free_batch, or one at
+ *    a time with -b
+ */
+static void batch_free(int count, char **blocks)
+{
+    int j;
+
+    if (batch_split) {
+	for (j = 0; j < count; j++)
+	    mm_free(blocks[j]);
+    }
+    else
+	mm_free_batch((void **)blocks, count);
+}
+
 /*************************************
  * Some miscellaneous helper routines
  ************************************/
 
 
 /*
- * printresults - prints a performance summary for some malloc package
+ * printresults - prints a performance summary for some malloc package;
+ *    if mm is set, with the columns asked for by -F and -M
  */
-static void printresults(int n, stats_t *stats) 
+static void printresults(int n, stats_t *stats, int mm) 
 {
-    int i;
+    int i, k;
+    int frag = mm && frag_mode, foot = mm && foot_mode;
     double secs = 0;
     double ops = 0;
     double util = 0;
-
-    /* Print the individual results for each trace */
-    printf("%5s%7s %5s%8s%10s%6s\n", 
-	   "trace", " valid", "util", "ops", "secs", "Kops");
+    double rest[4] = {0, 0, 0, 0};
+    double tw[2] = {0, 0}, rss_peak = 0;
+
+    /* Print the individual results for each trace, with the breakdown
+       of the rest of the heap and the footprint after util if asked for */
+    printf("%5s%7s %5s", "trace", " valid", "util");
+    if (frag)
+	printf("%7s%7s%7s%7s", "meta", "slack", "resv", "free");
+    if (foot)
+	printf("%6s%6s%7s", "twu", "rssu", "rssKB");
+    printf("%8s%10s%6s\n", "ops", "secs", "Kops");
     for (i=0; i < n; i++) {
 	if (stats[i].valid) {
-	    printf("%2d%10s%5.0f%%%8.0f%10.6f%6.0f\n", 
+	    printf("%2d%10s%5.0f%%", 
 		   i,
 		   "yes",
-		   stats[i].util*100.0,
+		   stats[i].util*100.0);
+	    for (k = 0; frag && k < 4; k++) {
+		printf("%6.1f%%", stats[i].frag[k]*100.0);
+		rest[k] += stats[i].frag[k];
+	    }
+	    if (foot) {
+		printf("%5.0f%%%5.0f%%%7.0f", stats[i].foot[0]*100.0,
+		       stats[i].foot[1]*100.0, stats[i].foot[2]/1024);
+		tw[0] += stats[i].foot[0];
+		tw[1] += stats[i].foot[1];
+		if (stats[i].foot[2] > rss_peak)
+		    rss_peak = stats[i].foot[2];
+	    }
+	    printf("%8.0f%10.6f%6.0f\n", 
 		   stats[i].ops,
 		   stats[i].secs,
 		   (stats[i].ops/1e3)/stats[i].secs);
@@ -942,10 +1901,15 @@ static void printresults(int n, stats_t *stats)
 	    util += stats[i].util;
 	}
 	else {
-	    printf("%2d%10s%6s%8s%10s%6s\n", 
+	    printf("%2d%10s%6s", 
 		   i,
 		   "no",
-		   "-",
+		   "-");
+	    if (frag)
+		printf("%7s%7s%7s%7s", "-", "-", "-", "-");
+	    if (foot)
+		printf("%6s%6s%7s", "-", "-", "-");
+	    printf("%8s%10s%6s\n", 
 		   "-",
 		   "-",
 		   "-");
@@ -954,17 +1918,28 @@ static void printresults(int n, stats_t *stats)
 
     /* Print the aggregate results for the set of traces */
     if (errors == 0) {
-	printf("%12s%5.0f%%%8.0f%10.6f%6.0f\n", 
+	printf("%12s%5.0f%%", 
 	       "Total       ",
-	       (util/n)*100.0,
+	       (util/n)*100.0);
+	for (k = 0; frag && k < 4; k++)
+	    printf("%6.1f%%", (rest[k]/n)*100.0);
+	if (foot)
+	    printf("%5.0f%%%5.0f%%%7.0f", (tw[0]/n)*100.0, (tw[1]/n)*100.0,
+		   rss_peak/1024);
+	printf("%8.0f%10.6f%6.0f\n", 
 	       ops, 
 	       secs,
 	       (ops/1e3)/secs);
     }
     else {
-	printf("%12s%6s%8s%10s%6s\n", 
+	printf("%12s%6s", 
 	       "Total       ",
-	       "-", 
+	       "-");
+	if (frag)
+	    printf("%7s%7s%7s%7s", "-", "-", "-", "-");
+	if (foot)
+	    printf("%6s%6s%7s", "-", "-", "-");
+	printf("%8s%10s%6s\n", 
 	       "-", 
 	       "-", 
 	       "-");
@@ -972,6 +1947,157 @@ static void printresults(int n, stats_t *stats)
 
 }
 
+/*
+ * parse_limits - Parse the -P latency limits, such as
+ *    "p99=2000,p99.9=10000,max=50000", in ns; max is p100
+ */
+static int parse_limits(char *spec)
+{
+    char *s = spec, *end;
+
+    while (*s != '\0') {
+	if (num_limits == MAX_LIMITS)
+	    return -1;
+	if (!strncmp(s, "max=", 4)) {
+	    limit_pct[num_limits] = 100;
+	    s += 3;
+	} else if (*s == 'p') {
+	    limit_pct[num_limits] = strtod(s + 1, &end);
+	    if (end == s + 1 || *end != '=' || 
+		limit_pct[num_limits] <= 0 || limit_pct[num_limits] > 100)
+		return -1;
+	    s = end;
+	} else
+	    return -1;
+	limit_ns[num_limits] = strtod(s + 1, &end);
+	if (end == s + 1 || (*end != ',' && *end != '\0'))
+	    return -1;
+	num_limits++;
+	s = (*end == ',') ? end + 1 : end;
+    }
+    return 0;
+}
+
+/*
+ * printlatency - prints the p50/p99/p99.9/max latency of each request
+ *    type on each trace, and each latency over a -P limit; returns how
+ *    many there were
+ */
+static int printlatency(int n, stats_t *stats)
+{
+    int i, t, k, failures = 0;
+    lat_hist_t *h;
+    double ns;
+
+    printf("Latency in ns:\n");
+    printf("%5s %-8s%10s%8s%8s%8s%10s\n", "trace", "request", "count",
+	   "p50", "p99", "p99.9", "max");
+    for (i = 0; i < n; i++) {
+	for (t = 0; stats[i].lat != NULL && t < NUM_OP_TYPES; t++) {
+	    h = &stats[i].lat[t];
+	    if (h->n == 0)
+		continue;
+	    printf("%5d %-8s%10lu%8.0f%8.0f%8.0f%10.0f\n", i, op_names[t], 
+		   h->n,
+		   lat_ns(lat_percentile(h, 50)),
+		   lat_ns(lat_percentile(h, 99)),
+		   lat_ns(lat_percentile(h, 99.9)),
+		   lat_ns(h->max));
+	    for (k = 0; k < num_limits; k++) {
+		ns = lat_ns(lat_percentile(h, limit_pct[k]));
+		if (ns > limit_ns[k]) {
+		    printf("ERROR [trace %d]: %s p%g is %.0f ns, over %.0f ns\n",
+			   i, op_names[t], limit_pct[k], ns, limit_ns[k]);
+		    failures++;
+		}
+	    }
+	}
+    }
+    return failures;
+}
+
+/*
+ * printruns - prints the mean, median, standard deviation and the 95%
+ *    confidence interval of the mean of the -r throughputs of each
+ *    trace, and of the throughput of all the traces in each round
+ */
+static void printruns(int n, stats_t *stats)
+{
+    int i, r;
+    double *kops = malloc(reps * sizeof(double));
+    double *ops = calloc(reps, sizeof(double));
+    double *secs = calloc(reps, sizeof(double));
+    runstats_t rs;
+
+    if (kops == NULL || ops == NULL || secs == NULL)
+	unix_error("malloc failed in printruns");
+    printf("Throughput over %d runs, in Kops:\n", reps);
+    printf("%5s%9s%9s%9s%9s\n", "trace", "mean", "median", "stddev", "95% ci");
+    for (i = 0; i < n; i++) {
+	for (r = 0; r < reps; r++) {
+	    kops[r] = stats[i].ops / 1e3 / stats[i].runs[r];
+	    ops[r] += stats[i].ops;
+	    secs[r] += stats[i].runs[r];
+	}
+	runstats(kops, reps, &rs);
+	printf("%5d%9.0f%9.0f%9.0f%8.1f%%\n", i, rs.mean, rs.median, rs.sd,
+	       rs.ci / rs.mean * 100.0);
+    }
+    for (r = 0; r < reps; r++)
+	kops[r] = ops[r] / 1e3 / secs[r];
+    runstats(kops, reps, &rs);
+    printf("%5s%9.0f%9.0f%9.0f%8.1f%%\n", "Total", rs.mean, rs.median,
+	   rs.sd, rs.ci / rs.mean * 100.0);
+    free(kops);
+    free(ops);
+    free(secs);
+}
+
+/*
+ * printcounters - prints the hardware events per request of each
+ *    trace, and over all of them. Instructions per request hardly
+ *    vary from run to run, so they show a change in mm.c's speed
+ *    that the timings would lose in their noise.
+ */
+static void printcounters(int n, stats_t *stats)
+{
+    int i, k;
+    double ops = 0, total[PERF_NUM];
+
+    printf("Hardware events per request:\n");
+    printf("%5s", "trace");
+    for (k = 0; k < PERF_NUM; k++) {
+	printf("%9s", perf_name(k));
+	total[k] = 0;
+    }
+    printf("\n");
+    for (i = 0; i < n; i++) {
+	if (!stats[i].valid)
+	    continue;
+	printf("%5d", i);
+	for (k = 0; k < PERF_NUM; k++) {
+	    if (stats[i].perf[k] < 0) {
+		printf("%9s", "-");
+		total[k] = -1;
+	    } else {
+		printf("%9.2f", stats[i].perf[k] / stats[i].ops);
+		if (total[k] >= 0)
+		    total[k] += stats[i].perf[k];
+	    }
+	}
+	printf("\n");
+	ops += stats[i].ops;
+    }
+    printf("%5s", "Total");
+    for (k = 0; k < PERF_NUM; k++) {
+	if (ops == 0 || total[k] < 0)
+	    printf("%9s", "-");
+	else
+	    printf("%9.2f", total[k] / ops);
+    }
+    printf("\n");
+}
+
 /* 
  * app_error - Report an arbitrary application error
  */
@@ -1004,14 +2130,31 @@ void malloc_error(int tracenum, int opnum, char *msg)
  */
 static void usage(void) 
 {
-    fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+    fprintf(stderr, "Usage: mdriver [-hvVGalRbSFMHC] [-f <file>] [-t <dir>] [-A <n>] [-T <n>]\n"
+	    "               [-P <limits>] [-k <timer>] [-p <cpu>] [-w <n>]\n"
+	    "               [-r <n>]\n");
     fprintf(stderr, "Options\n");
     fprintf(stderr, "\t-a         Don't check the team structure.\n");
+    fprintf(stderr, "\t-A <n>     Then replay the traces n times over on one heap.\n");
+    fprintf(stderr, "\t-b         Replay batch ops one block at a time.\n");
+    fprintf(stderr, "\t-C         Count hardware events per request.\n");
     fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
+    fprintf(stderr, "\t-F         Break down the rest of the heap at peak payload.\n");
     fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
+    fprintf(stderr, "\t-G         Print util and throughput of every run, for mdcompare.\n");
     fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-H         Histogram the latency of each request.\n");
+    fprintf(stderr, "\t-k <tmr>   Time with gettod, itimer, fcyc, mono or tsc.\n");
     fprintf(stderr, "\t-l         Run libc malloc as well.\n");
+    fprintf(stderr, "\t-M         Integrate util and resident pages over each trace.\n");
+    fprintf(stderr, "\t-p <cpu>   Run on CPU cpu only.\n");
+    fprintf(stderr, "\t-P <lim>   Fail if latencies exceed lim, e.g. p99=2000,max=50000 (ns).\n");
+    fprintf(stderr, "\t-r <n>     Time each trace n times and summarize the runs.\n");
+    fprintf(stderr, "\t-R         Replay allocations through a region (request traces).\n");
+    fprintf(stderr, "\t-S         Stream binary traces instead of loading them.\n");
     fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+    fprintf(stderr, "\t-T <n>     Sample the heap every n requests into <trace>-timeline.csv.\n");
     fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
     fprintf(stderr, "\t-V         Print additional debug info.\n");
+    fprintf(stderr, "\t-w <n>     Run each trace n times untimed before timing it.\n");
 }
@@ -2,6 +2,15 @@
  * memlib.c - a module that simulates the memory system.  Needed because it 
  *            allows us to interleave calls from the student's malloc package 
  *            with the system's malloc package in libc.
+ *
+ *            Besides the default heap used by mem_sbrk() and friends, any
+ *            number of independent heaps can be created with mem_create().
+ *            Each one is a single private mapping, so mem_destroy() releases
+ *            all of its storage at once.
+ *
+ *            Each heap remembers the highest brk it has reached, so the
+ *            allocator can tell storage that is still zero from storage
+ *            it has written since a mem_reset_brk().
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,24 +23,65 @@
 #include "memlib.h"
 #include "config.h"
 
+/* mem_zero() hands whole pages back for ranges at least this large */
+#define ZERO_PAGES_MIN (1<<20)
+
+/* Pages mem_resident() asks mincore() about at a time */
+#define RESIDENT_CHUNK 1024
+
+/* Where mem_map() places storage on a 64-bit host */
+#define LOW_HINT  0x80000000UL
+#define LOW_LIMIT 0x100000000UL
+#define LOW_STEP  0x4000000UL    /* 64MB between hints */
+
 /* private variables */
-static char *mem_start_brk;  /* points to first byte of heap */
-static char *mem_brk;        /* points to last byte of heap */
-static char *mem_max_addr;   /* largest legal heap address */ 
+static mem_t mem_default_heap;  /* the heap behind mem_sbrk() */
+
+/*
+ * mem_map - reserve size bytes of zeroed, page-aligned storage. The
+ *    allocator stores heap addresses in 32-bit words, so on a 64-bit
+ *    host the storage must lie below 4GB: look for a free range
+ *    between 2GB and 4GB first, stepping the hint past heaps that are
+ *    already mapped there, then try MAP_32BIT's smaller window.
+ */
+static char *mem_map(size_t size)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    void *p;
+#if defined(__x86_64__)
+    unsigned long hint;
+
+    for (hint = LOW_HINT; hint + size <= LOW_LIMIT; hint += LOW_STEP) {
+	p = mmap((void *)hint, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (p == MAP_FAILED)
+	    break;
+	if ((unsigned long)p + size <= LOW_LIMIT)
+	    return (char *)p;
+	munmap(p, size);
+    }
+    flags |= MAP_32BIT;
+#endif
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+    return (p == MAP_FAILED) ? NULL : (char *)p;
+}
 
 /* 
  * mem_init - initialize the memory system model
  */
 void mem_init(void)
 {
+    mem_t *mem = &mem_default_heap;
+
     /* allocate the storage we will use to model the available VM */
-    if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
-	fprintf(stderr, "mem_init_vm: malloc error\n");
+    if ((mem->start_brk = mem_map(MAX_HEAP)) == NULL) {
+	fprintf(stderr, "mem_init_vm: mmap error\n");
 	exit(1);
     }
 
-    mem_max_addr = mem_start_brk + MAX_HEAP;  /* max legal heap address */
-    mem_brk = mem_start_brk;                  /* heap is empty initially */
+    mem->max_addr = mem->start_brk + MAX_HEAP;  /* max legal heap address */
+    mem->brk = mem->start_brk;                  /* heap is empty initially */
+    mem->fresh_brk = mem->start_brk;
 }
 
 /* 
@@ -39,7 +89,48 @@ void mem_init(void)
  */
 void mem_deinit(void)
 {
-    free(mem_start_brk);
+    munmap(mem_default_heap.start_brk, MAX_HEAP);
+}
+
+/*
+ * mem_default - return the heap that mem_sbrk() and friends operate on
+ */
+mem_t *mem_default(void)
+{
+    return &mem_default_heap;
+}
+
+/*
+ * mem_create - create an independent heap of at most max_heap bytes.
+ *    The mem_t record lives in the first page of the mapping, in front
+ *    of the heap storage. Returns NULL if the storage can't be mapped.
+ */
+mem_t *mem_create(size_t max_heap)
+{
+    size_t pagesize = mem_pagesize();
+    char *base;
+    mem_t *mem;
+
+    max_heap = (max_heap + pagesize - 1) & ~(pagesize - 1);
+    if ((base = mem_map(pagesize + max_heap)) == NULL)
+	return NULL;
+
+    mem = (mem_t *)base;
+    mem->start_brk = base + pagesize;
+    mem->brk = mem->start_brk;
+    mem->max_addr = mem->start_brk + max_heap;
+    mem->fresh_brk = mem->start_brk;
+    return mem;
+}
+
+/*
+ * mem_destroy - release a heap made by mem_create and all of its storage
+ */
+void mem_destroy(mem_t *mem)
+{
+    char *base = (char *)mem;
+
+    munmap(base, mem->max_addr - base);
 }
 
 /*
@@ -47,7 +138,31 @@ void mem_deinit(void)
  */
 void mem_reset_brk()
 {
-    mem_brk = mem_start_brk;
+    mem_reset_brk_r(&mem_default_heap);
+}
+
+void mem_reset_brk_r(mem_t *mem)
+{
+    mem->brk = mem->start_brk;
+}
+
+/*
+ * mem_purge - reset the brk pointer as mem_reset_brk does, and give
+ *    every page the heap has used back to the kernel, so that the
+ *    storage takes no memory, and reads as zero, until it is used again
+ */
+void mem_purge()
+{
+    mem_purge_r(&mem_default_heap);
+}
+
+void mem_purge_r(mem_t *mem)
+{
+    if (mem->fresh_brk > mem->start_brk &&
+	madvise(mem->start_brk, mem->fresh_brk - mem->start_brk,
+		MADV_DONTNEED) == 0)
+	mem->fresh_brk = mem->start_brk;
+    mem->brk = mem->start_brk;
 }
 
 /* 
@@ -57,14 +172,23 @@ void mem_reset_brk()
  */
 void *mem_sbrk(int incr) 
 {
-    char *old_brk = mem_brk;
+    return mem_sbrk_r(&mem_default_heap, incr);
+}
+
+void *mem_sbrk_r(mem_t *mem, int incr)
+{
+    char *old_brk = mem->brk;
 
-    if ( (incr < 0) || ((mem_brk + incr) > mem_max_addr)) {
+    if ( (incr < 0) || ((mem->brk + incr) > mem->max_addr)) {
 	errno = ENOMEM;
+#ifndef MM_PRELOAD
 	fprintf(stderr, "ERROR: mem_sbrk failed. Ran out of memory...\n");
+#endif
 	return (void *)-1;
     }
-    mem_brk += incr;
+    mem->brk += incr;
+    if (mem->brk > mem->fresh_brk)
+	mem->fresh_brk = mem->brk;
     return (void *)old_brk;
 }
 
@@ -73,7 +197,12 @@ void *mem_sbrk(int incr)
  */
 void *mem_heap_lo()
 {
-    return (void *)mem_start_brk;
+    return mem_heap_lo_r(&mem_default_heap);
+}
+
+void *mem_heap_lo_r(mem_t *mem)
+{
+    return (void *)mem->start_brk;
 }
 
 /* 
@@ -81,7 +210,12 @@ void *mem_heap_lo()
  */
 void *mem_heap_hi()
 {
-    return (void *)(mem_brk - 1);
+    return mem_heap_hi_r(&mem_default_heap);
+}
+
+void *mem_heap_hi_r(mem_t *mem)
+{
+    return (void *)(mem->brk - 1);
 }
 
 /*
@@ -89,7 +223,39 @@ void *mem_heap_hi()
  */
 size_t mem_heapsize() 
 {
-    return (size_t)(mem_brk - mem_start_brk);
+    return mem_heapsize_r(&mem_default_heap);
+}
+
+size_t mem_heapsize_r(mem_t *mem)
+{
+    return (size_t)(mem->brk - mem->start_brk);
+}
+
+/*
+ * mem_resident() - returns how many bytes of the heap are resident in
+ *    memory, as mincore() counts the pages, or 0 if it can't tell
+ */
+size_t mem_resident()
+{
+    return mem_resident_r(&mem_default_heap);
+}
+
+size_t mem_resident_r(mem_t *mem)
+{
+    unsigned char vec[RESIDENT_CHUNK];
+    size_t pagesize = mem_pagesize();
+    size_t npages = (mem->brk - mem->start_brk + pagesize - 1) / pagesize;
+    size_t i, n, resident = 0;
+    char *p = mem->start_brk;
+
+    for (; npages > 0; npages -= n, p += n * pagesize) {
+	n = (npages < RESIDENT_CHUNK) ? npages : RESIDENT_CHUNK;
+	if (mincore(p, n * pagesize, (void *)vec) < 0)
+	    return 0;
+	for (i = 0; i < n; i++)
+	    resident += vec[i] & 1;
+    }
+    return resident * pagesize;
 }
 
 /*
@@ -99,3 +265,42 @@ size_t mem_pagesize()
 {
     return (size_t)getpagesize();
 }
+
+/*
+ * mem_fresh_lo - return the lowest address that mem_sbrk has never
+ *    handed out. Storage from there up to the end of the heap's
+ *    reservation is still zero.
+ */
+void *mem_fresh_lo()
+{
+    return mem_fresh_lo_r(&mem_default_heap);
+}
+
+void *mem_fresh_lo_r(mem_t *mem)
+{
+    return (void *)mem->fresh_brk;
+}
+
+/*
+ * mem_zero - zero len bytes of heap storage at ptr. The whole pages
+ *    of a large range are given back to the kernel instead of being
+ *    written, and read as zero on their next use.
+ */
+void mem_zero(void *ptr, size_t len)
+{
+    size_t pagesize = mem_pagesize();
+    char *lo = (char *)ptr;
+    char *hi = lo + len;
+    char *page_lo, *page_hi;
+
+    if (len >= ZERO_PAGES_MIN) {
+	page_lo = (char *)(((unsigned long)lo + pagesize - 1) & ~(pagesize - 1));
+	page_hi = (char *)((unsigned long)hi & ~(pagesize - 1));
+	if (madvise(page_lo, page_hi - page_lo, MADV_DONTNEED) == 0) {
+	    memset(lo, 0, page_lo - lo);
+	    memset(page_hi, 0, hi - page_hi);
+	    return;
+	}
+    }
+    memset(ptr, 0, len);
+}
@@ -1,11 +1,52 @@
+#ifndef __MEMLIB_H_
+#define __MEMLIB_H_
+
 #include <unistd.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * mem_t - one simulated heap: a fixed reservation of virtual memory
+ * and a brk pointer that only grows (until it is reset). Storage at
+ * and above fresh_brk has never been handed out and still reads as zero.
+ */
+typedef struct {
+    char *start_brk;  /* points to first byte of heap */
+    char *brk;        /* points to last byte of heap */
+    char *max_addr;   /* largest legal heap address */
+    char *fresh_brk;  /* high-water mark of brk */
+} mem_t;
+
 void mem_init(void);               
 void mem_deinit(void);
 void *mem_sbrk(int incr);
 void mem_reset_brk(void); 
+void mem_purge(void);
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+size_t mem_resident(void);
 size_t mem_pagesize(void);
+void *mem_fresh_lo(void);
+void mem_zero(void *ptr, size_t len);
+
+/* Independent heaps; the functions above operate on mem_default() */
+mem_t *mem_default(void);
+mem_t *mem_create(size_t max_heap);
+void mem_destroy(mem_t *mem);
+void *mem_sbrk_r(mem_t *mem, int incr);
+void mem_reset_brk_r(mem_t *mem);
+void mem_purge_r(mem_t *mem);
+void *mem_heap_lo_r(mem_t *mem);
+void *mem_heap_hi_r(mem_t *mem);
+size_t mem_heapsize_r(mem_t *mem);
+size_t mem_resident_r(mem_t *mem);
+void *mem_fresh_lo_r(mem_t *mem);
+
+#ifdef __cplusplus
+}
+#endif
 
+#endif /* __MEMLIB_H_ */
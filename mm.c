@@ -8,6 +8,15 @@
  * Free list are tagged to the segregated list.
  * Therefore all free block contains pointer to the predecessor and successor.
  * The segregated list headers are organized by 2^k size.
+ *
+ * All allocator state lives in an mm_heap_t: the segregated list headers
+ * and the memlib heap the blocks are carved from. mm_heap_create() makes
+ * an independent heap; the mm_* entry points operate on a default heap
+ * backed by the memlib default heap.
+ *
+ * A free block whose payload has not been written since extend_heap()
+ * took it from fresh memlib storage carries the FRESH bit in its header,
+ * so mm_calloc() only has to clear its free-list links.
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -35,8 +44,16 @@ team_t team = {
     ""
 };
 
-/* single word (4) or double word (8) alignment */
-#define ALIGNMENT 8
+/* Payload alignment: 8, 16, 32 or 64, set with -DALIGNMENT=n */
+#ifndef ALIGNMENT
+#define ALIGNMENT MM_ALIGNMENT
+#endif
+#if ALIGNMENT < 8 || ALIGNMENT > 64 || (ALIGNMENT & (ALIGNMENT - 1)) != 0
+#error "ALIGNMENT must be 8, 16, 32 or 64"
+#endif
+#if ALIGNMENT != MM_ALIGNMENT
+#error "ALIGNMENT and MM_ALIGNMENT differ"
+#endif
 
 /* Basic constants and macros */
 #define WSIZE 4  // Word and header/footer size (bytes)
@@ -44,8 +61,14 @@ team_t team = {
 #define INITCHUNKSIZE (1<<6)
 #define CHUNKSIZE (1<<12)  // Extend heap by this amount (bytes)
 
-#define LISTLIMIT 20
+// Largest request, and largest memalign alignment: block sizes must fit
+// the 32-bit header and extend_heap's int increment, with room to spare
+// for an alignment gap
+#define MAX_REQUEST MM_MAX_REQUEST
+
+#define LISTLIMIT MM_LISTLIMIT
 #define REALLOC_BUFFER (1<<7)
+#define BATCH_SORT 64  // Pointers sorted at a time by mm_free_batch
 
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
@@ -59,7 +82,7 @@ team_t team = {
 #define PUT_NOTAG(p, val) (*(unsigned int *)(p) = (val))
 
 // Store predecessor or successor pointer for free blocks
-#define SET_PTR(p, ptr) (*(unsigned int *)(p) = (unsigned int)(ptr))
+#define SET_PTR(p, ptr) (*(unsigned int *)(p) = (unsigned int)(unsigned long)(ptr))
 
 /* Read the size and allocated fields from address p */
 #define GET_SIZE(p) (GET(p) & ~0x7)
@@ -68,6 +91,10 @@ team_t team = {
 #define REMOVE_RATAG(p) (GET(p) &= ~0x2)
 #define SET_RATAG(p)  (GET(p) |= 0x2)
 
+// Free block payload is still zero apart from its free-list links
+#define FRESH 0x4
+#define GET_FRESH(p) (GET(p) & FRESH)
+
 /* Given block ptr bp, compute address of its header and footer */
 #define HDRP(bp) ((char *)(bp) - WSIZE)
 #define FTRP(bp) ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE)
@@ -80,75 +107,156 @@ team_t team = {
 #define SUCC_PTR(ptr) ((char *)(ptr) + WSIZE)
 
 // 가용블록 리스트의 이전 포인터와 다음 포인터
-#define PRED(bp) (*(char **)(bp))
-#define SUCC(ptr) (*(char **)(SUCC_PTR(ptr)))
+// Links are 32-bit words, as SET_PTR stores them; on a 64-bit build
+// memlib keeps the heap below 4GB so they still fit
+#define PRED(bp) ((char *)(unsigned long)GET(bp))
+#define SUCC(ptr) ((char *)(unsigned long)GET(SUCC_PTR(ptr)))
+
+// Zero the footer and header in front of bp and bp's free-list links
+#define CLEAR_SEAM(bp) memset((char *)(bp) - DSIZE, 0, 2 * DSIZE)
 // #define NEXT_FLP(bp) (*((char **)(bp) + 1))  // 1의 의미: sizeof(int) * 1 = 4
 
 /* rounds up to the nearest multiple of ALIGNMENT */
-#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~0x7)
+#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~(ALIGNMENT-1))
 // #define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
 
-void *segregated_free_lists[LISTLIMIT];
+// Smallest block: header, footer and the two free-list links
+#define MINBLOCK ALIGN(2 * DSIZE)
+
+// Words in front of the prologue so the first payload is aligned
+#define PROLOGUE_PAD (ALIGN(4 * WSIZE) - 4 * WSIZE)
+
+/* Allocator state for one heap */
+struct mm_heap {
+    void *segregated_free_lists[LISTLIMIT];
+    mem_t *mem;  // memlib heap the blocks are carved from
+    char *first_block;  // Block after the prologue, where a walk starts
+};
+
+static mm_heap_t default_heap;
 
 // static char *heap_listp;
 // static char *free_listp;  // 가용블록 리스트의 시작점을 가리키는 포인터
 
-static void *extend_heap(size_t);
-static void *coalesce(void *);
-static void *place(void *, size_t);
-static void insert_node(void *, size_t);
-static void delete_node(void *);
+static int heap_init(mm_heap_t *);
+static void *extend_heap(mm_heap_t *, size_t);
+static void *find_fit(mm_heap_t *, size_t);
+static void *find_fit_class(mm_heap_t *, size_t, int);
+static void *search_lists(mm_heap_t *, size_t, int, size_t);
+static int size_class(size_t);
+static void *find_aligned_fit(mm_heap_t *, size_t, size_t);
+static size_t aligned_gap(void *, size_t);
+static void *coalesce(mm_heap_t *, void *);
+static void *place(mm_heap_t *, void *, size_t);
+static void insert_node(mm_heap_t *, void *, size_t);
+static void delete_node(mm_heap_t *, void *);
 
 /* 
  * mm_init - initialize the malloc package.
  */
 int mm_init(void)
+{
+    default_heap.mem = mem_default();
+    return heap_init(&default_heap);
+}
+
+/*
+ * mm_heap_create - create an independent heap of at most max_size bytes.
+ *     The mm_heap_t record sits at the bottom of its own memlib heap,
+ *     so destroying the heap is a single unmap.
+ */
+mm_heap_t *mm_heap_create(size_t max_size)
+{
+    mem_t *mem;
+    mm_heap_t *heap;
+
+    if ((mem = mem_create(ALIGN(sizeof(mm_heap_t)) + max_size)) == NULL)
+        return NULL;
+
+    if ((long)(heap = mem_sbrk_r(mem, ALIGN(sizeof(mm_heap_t)))) == -1) {
+        mem_destroy(mem);
+        return NULL;
+    }
+    heap->mem = mem;
+
+    if (heap_init(heap) < 0) {
+        mem_destroy(mem);
+        return NULL;
+    }
+    return heap;
+}
+
+/*
+ * mm_default_heap - return the heap behind mm_malloc/mm_free/mm_realloc
+ */
+mm_heap_t *mm_default_heap(void)
+{
+    return &default_heap;
+}
+
+/*
+ * mm_heap_destroy - release a heap and every block allocated from it
+ */
+void mm_heap_destroy(mm_heap_t *heap)
+{
+    mem_destroy(heap->mem);
+}
+
+/*
+ * heap_init - set up empty free lists and the prologue/epilogue
+ *     blocks at the current break of the heap's memlib heap.
+ */
+static int heap_init(mm_heap_t *heap)
 {
     int list;
     char *heap_start;  // Pointer to beginning of heap
 
     // Initialize segregated free lists
     for (list = 0; list < LISTLIMIT; list++) {
-        segregated_free_lists[list] = NULL;
+        heap->segregated_free_lists[list] = NULL;
     }
 
     /* Allocate memory for the initial empty heap */
-    if ((long)(heap_start = mem_sbrk(4 * WSIZE)) == -1)
+    if ((long)(heap_start = mem_sbrk_r(heap->mem, PROLOGUE_PAD + 4 * WSIZE)) == -1)
         return -1;
+    heap_start += PROLOGUE_PAD;
 
     PUT_NOTAG(heap_start, 0);  // Alignment padding
     PUT_NOTAG(heap_start + (1 * WSIZE), PACK(DSIZE, 1));  // Prologue header
     PUT_NOTAG(heap_start + (2 * WSIZE), PACK(DSIZE, 1));  // Prologue footer
     PUT_NOTAG(heap_start + (3 * WSIZE), PACK(0, 1));  // Epilogue header
+    heap->first_block = heap_start + (4 * WSIZE);
 
     /* Extend the empty heap with a free block of CHUNKSIZE bytes */
-    if (extend_heap(INITCHUNKSIZE) == NULL)
+    if (extend_heap(heap, INITCHUNKSIZE) == NULL)
         return -1;
         
     return 0;
 }
 
-static void *extend_heap(size_t size)
+static void *extend_heap(mm_heap_t *heap, size_t size)
 {
     char *bp;
+    char *fresh_lo;
     size_t asize;
 
     asize = ALIGN(size);
 
-    if ((bp = mem_sbrk(asize)) == (void *)-1)
+    fresh_lo = mem_fresh_lo_r(heap->mem);
+    if ((bp = mem_sbrk_r(heap->mem, asize)) == (void *)-1)
         return NULL;
 
     /* Initialize free block header/footer and the epliogue header */
-    PUT_NOTAG(HDRP(bp), PACK(asize, 0));  // Free block header
+    PUT_NOTAG(HDRP(bp), PACK(asize, bp >= fresh_lo ? FRESH : 0));  // Free block header
     PUT_NOTAG(FTRP(bp), PACK(asize, 0));  // Free block footer
     PUT_NOTAG(HDRP(NEXT_BLKP(bp)), PACK(0, 1));  // New epilogue header
     // insert_node(bp, asize);
 
     /* Coalesce if the previous block was free */
-    return coalesce(bp);
+    return coalesce(heap, bp);
 }
 
-static void insert_node(void *ptr, size_t size) {
+static void insert_node(mm_heap_t *heap, void *ptr, size_t size) {
     int list = 0;
     void *search_ptr = ptr;
     void *insert_ptr = NULL;
@@ -160,7 +268,7 @@ static void insert_node(void *ptr, size_t size) {
     }
 
     // Keep size ascending order and search
-    search_ptr = segregated_free_lists[list];
+    search_ptr = heap->segregated_free_lists[list];
     while (search_ptr != NULL) {
         insert_ptr = search_ptr;  // 들어갈 자리의 이전 포인터
         search_ptr = PRED(search_ptr);  // 들어갈 자리의 다음 포인터
@@ -177,7 +285,7 @@ static void insert_node(void *ptr, size_t size) {
             SET_PTR(PRED_PTR(ptr), search_ptr);
             SET_PTR(SUCC_PTR(search_ptr), ptr);
             SET_PTR(SUCC_PTR(ptr), NULL);
-            segregated_free_lists[list] = ptr;
+            heap->segregated_free_lists[list] = ptr;
         }
     } else {
         if (insert_ptr != NULL) {
@@ -187,13 +295,13 @@ static void insert_node(void *ptr, size_t size) {
         } else {
             SET_PTR(PRED_PTR(ptr), NULL);
             SET_PTR(SUCC_PTR(ptr), NULL);
-            segregated_free_lists[list] = ptr;
+            heap->segregated_free_lists[list] = ptr;
         }
     }
     return;
 }
 
-static void delete_node(void *ptr) {
+static void delete_node(mm_heap_t *heap, void *ptr) {
     int list = 0;
     size_t size = GET_SIZE(HDRP(ptr));
 
@@ -209,13 +317,13 @@ static void delete_node(void *ptr) {
             SET_PTR(PRED_PTR(SUCC(ptr)), PRED(ptr));
         } else {
             SET_PTR(SUCC_PTR(PRED(ptr)), NULL);
-            segregated_free_lists[list] = PRED(ptr);
+            heap->segregated_free_lists[list] = PRED(ptr);
         }
     } else {
         if (SUCC(ptr) != NULL) {
             SET_PTR(PRED_PTR(SUCC(ptr)), NULL);
         } else {
-            segregated_free_lists[list] = NULL;
+            heap->segregated_free_lists[list] = NULL;
         }
     }
     return;
@@ -226,56 +334,331 @@ static void delete_node(void *ptr) {
  *     Always allocate a block whose size is a multiple of the alignment.
  */
 void *mm_malloc(size_t size)
+{
+    return mm_heap_malloc(&default_heap, size);
+}
+
+void *mm_heap_malloc(mm_heap_t *heap, size_t size)
 {
     size_t asize;  // Adjusted block size
-    size_t extendsize;  // Amount to extend heap if no fit
-    void *bp = NULL;
 
-    /* Ignore spurious requests */
-    if (size == 0)
+    /* Ignore spurious requests, and refuse ones no header can hold */
+    if (size == 0 || size > MAX_REQUEST)
         return NULL;
     
     /* Adjust block size to include overhead and alignment reqs. */
     if (size <= DSIZE)
-        asize = 2 * DSIZE;
+        asize = MINBLOCK;
     else
         asize = ALIGN(size + DSIZE);
 
-    int list = 0;
-    size_t searchsize = asize;
+    return mm_heap_malloc_class(heap, asize, size_class(asize));
+}
+
+/*
+ * mm_malloc_class - Allocate a block of asize bytes, searching from
+ *     segregated list list. Both come from MM_BLOCK_SIZE() and
+ *     MM_SIZE_CLASS() in mm.h, usually folded at compile time by
+ *     mm_malloc_fixed().
+ */
+void *mm_malloc_class(size_t asize, int list)
+{
+    return mm_heap_malloc_class(&default_heap, asize, list);
+}
+
+void *mm_heap_malloc_class(mm_heap_t *heap, size_t asize, int list)
+{
+    size_t extendsize;  // Amount to extend heap if no fit
+    void *bp = NULL;
+
     /* Search for free block in segregated list */
-    while (list < LISTLIMIT) {
-        if ((list == LISTLIMIT - 1) || ((searchsize <= 1) && (segregated_free_lists[list] != NULL))) {
-            bp = segregated_free_lists[list];
-            // Ignore blocks that are too small or mared with the reallocation bit
-            while ((bp != NULL) && ((asize > GET_SIZE(HDRP(bp))) || (GET_TAG(HDRP(bp))))) {
-                bp = PRED(bp);
-            }
-            if (bp != NULL)
-                break;
-        }
-        searchsize >>= 1;
-        list++;
-    }
+    bp = find_fit_class(heap, asize, list);
 
     /* If free block is not found, extend the heap */
     if (bp == NULL) {
         extendsize = MAX(asize, CHUNKSIZE);
 
-        if ((bp = extend_heap(extendsize)) == NULL)
+        if ((bp = extend_heap(heap, extendsize)) == NULL)
             return NULL;
     }
     
     // Place and divice block
-    bp = place(bp, asize);
+    bp = place(heap, bp, asize);
     // last_bp = bp;
     return bp;
 }
 
+/*
+ * mm_calloc - Allocate a zeroed array of nmemb elements of size bytes.
+ *     A block carved from fresh storage only needs its free-list links
+ *     cleared; anything else is zeroed through mem_zero(), which gives
+ *     the whole pages of a large block back instead of writing them.
+ */
+void *mm_calloc(size_t nmemb, size_t size)
+{
+    return mm_heap_calloc(&default_heap, nmemb, size);
+}
+
+void *mm_heap_calloc(mm_heap_t *heap, size_t nmemb, size_t size)
+{
+    size_t bytes;
+    size_t asize;  // Adjusted block size
+    size_t fresh;
+    void *bp;
+
+    if (nmemb == 0 || size == 0 || nmemb > (size_t)-1 / size)
+        return NULL;
+    bytes = nmemb * size;
+    if (bytes > MAX_REQUEST)
+        return NULL;
+
+    if (bytes <= DSIZE)
+        asize = MINBLOCK;
+    else
+        asize = ALIGN(bytes + DSIZE);
+
+    if ((bp = find_fit(heap, asize)) == NULL &&
+        (bp = extend_heap(heap, MAX(asize, CHUNKSIZE))) == NULL)
+        return NULL;
+
+    fresh = GET_FRESH(HDRP(bp));
+    bp = place(heap, bp, asize);
+    if (fresh)
+        memset(bp, 0, MIN(bytes, DSIZE));
+    else
+        mem_zero(bp, bytes);
+    return bp;
+}
+
+/*
+ * mm_memalign - Allocate a block whose payload is aligned to align bytes
+ *     (a power of 2). A free block that holds the payload after its gap
+ *     is taken; the gap in front of the aligned payload becomes a free
+ *     block of its own, and anything past the payload is split off as
+ *     usual, so the aligned block is an ordinary block that mm_free can
+ *     release.
+ */
+void *mm_memalign(size_t align, size_t size)
+{
+    return mm_heap_memalign(&default_heap, align, size);
+}
+
+void *mm_heap_memalign(mm_heap_t *heap, size_t align, size_t size)
+{
+    size_t asize;  // Adjusted block size
+    size_t csize;  // Size of the free block we carve from
+    size_t gap;  // Bytes in front of the aligned payload
+    size_t remainder;
+    size_t fresh;
+    char *bp;
+    char *abp;  // Aligned block pointer
+
+    if (size == 0 || size > MAX_REQUEST || align > MAX_REQUEST ||
+        (align & (align - 1)) != 0)
+        return NULL;
+    if (align <= ALIGNMENT)
+        return mm_heap_malloc(heap, size);
+
+    if (size <= DSIZE)
+        asize = MINBLOCK;
+    else
+        asize = ALIGN(size + DSIZE);
+
+    // A new chunk needs room for a leading gap of up to align + MINBLOCK
+    if ((bp = find_aligned_fit(heap, asize, align)) == NULL &&
+        (bp = extend_heap(heap, MAX(asize + align + MINBLOCK, CHUNKSIZE))) == NULL)
+        return NULL;
+
+    csize = GET_SIZE(HDRP(bp));
+    fresh = GET_FRESH(HDRP(bp));
+    delete_node(heap, bp);
+
+    gap = aligned_gap(bp, align);
+    abp = (char *)bp + gap;
+
+    if (gap > 0) {
+        PUT(HDRP(bp), PACK(gap, fresh));
+        PUT_NOTAG(FTRP(bp), PACK(gap, 0));
+        insert_node(heap, bp, gap);
+        PUT_NOTAG(HDRP(abp), 0);  // New header, no realloc tag
+    }
+
+    remainder = csize - gap - asize;
+    if (remainder <= DSIZE * 2) {
+        // Do not split block
+        PUT(HDRP(abp), PACK(asize + remainder, 1));
+        PUT_NOTAG(FTRP(abp), PACK(asize + remainder, 1));
+    } else {
+        // Split block
+        PUT(HDRP(abp), PACK(asize, 1));
+        PUT_NOTAG(FTRP(abp), PACK(asize, 1));
+        PUT_NOTAG(HDRP(NEXT_BLKP(abp)), PACK(remainder, fresh));
+        PUT_NOTAG(FTRP(NEXT_BLKP(abp)), PACK(remainder, 0));
+        insert_node(heap, NEXT_BLKP(abp), remainder);
+    }
+    return abp;
+}
+
+/*
+ * aligned_gap - Bytes from bp to the first align-byte boundary that
+ *     leaves either no gap or one big enough to hold a free block
+ */
+static size_t aligned_gap(void *bp, size_t align)
+{
+    size_t gap = (align - ((unsigned long)bp & (align - 1))) & (align - 1);
+
+    if (gap != 0 && gap < MINBLOCK)
+        gap += align;
+    return gap;
+}
+
+/*
+ * mm_aligned_alloc - C11-style aligned allocation, same as mm_memalign
+ */
+void *mm_aligned_alloc(size_t align, size_t size)
+{
+    return mm_heap_memalign(&default_heap, align, size);
+}
+
+/*
+ * find_fit - Search the segregated lists for a free block of at least
+ *     asize bytes, starting at the list for asize's size class.
+ */
+static void *find_fit(mm_heap_t *heap, size_t asize)
+{
+    return find_fit_class(heap, asize, size_class(asize));
+}
+
+/*
+ * find_fit_class - find_fit with the first list to search already known
+ */
+static void *find_fit_class(mm_heap_t *heap, size_t asize, int list)
+{
+    return search_lists(heap, asize, list, 0);
+}
+
+/*
+ * search_lists - Walk the segregated lists from list up for a free block
+ *     that holds asize bytes after the gap that aligns its payload to
+ *     align bytes (no gap if align is 0)
+ */
+static inline void *search_lists(mm_heap_t *heap, size_t asize, int list,
+                                 size_t align)
+{
+    void *bp = NULL;
+
+    for (; list < LISTLIMIT; list++) {
+        bp = heap->segregated_free_lists[list];
+        // Ignore blocks that are too small or mared with the reallocation bit
+        while ((bp != NULL) &&
+               ((asize + (align ? aligned_gap(bp, align) : 0) > GET_SIZE(HDRP(bp))) ||
+                (GET_TAG(HDRP(bp))))) {
+            bp = PRED(bp);
+        }
+        if (bp != NULL)
+            break;
+    }
+    return bp;
+}
+
+/*
+ * size_class - Index of the segregated list that holds blocks of size
+ *     bytes: floor(log2(size)), capped at the last list
+ */
+static int size_class(size_t size)
+{
+    int list = 0;
+
+    while ((list < LISTLIMIT - 1) && (size > 1)) {
+        size >>= 1;
+        list++;
+    }
+    return list;
+}
+
+/*
+ * find_aligned_fit - Like find_fit, but the block must hold asize bytes
+ *     after the gap that aligns its payload to align bytes.
+ */
+static void *find_aligned_fit(mm_heap_t *heap, size_t asize, size_t align)
+{
+    return search_lists(heap, asize, size_class(asize), align);
+}
+
+/*
+ * mm_malloc_batch - Allocate n blocks of size bytes each and store them
+ *     in out[]. All n blocks are carved from one free block (or one heap
+ *     extension) in a single pass, so the free lists are touched once.
+ *     Returns n, or 0 if nothing was allocated.
+ */
+int mm_malloc_batch(size_t size, int n, void **out)
+{
+    return mm_heap_malloc_batch(&default_heap, size, n, out);
+}
+
+int mm_heap_malloc_batch(mm_heap_t *heap, size_t size, int n, void **out)
+{
+    size_t asize;  // Adjusted block size
+    size_t total;  // Space needed for all n blocks
+    size_t csize;  // Size of the free block being carved
+    size_t remainder;
+    size_t fresh;
+    char *bp;
+    int i;
+
+    if (size == 0 || n <= 0 || size > MAX_REQUEST)
+        return 0;
+
+    if (size <= DSIZE)
+        asize = MINBLOCK;
+    else
+        asize = ALIGN(size + DSIZE);
+    // The whole run must fit in one block header, like a single request
+    if ((size_t)n > MAX_REQUEST / asize)
+        return 0;
+    total = asize * n;
+
+    if ((bp = find_fit(heap, total)) == NULL &&
+        (bp = extend_heap(heap, MAX(total, CHUNKSIZE))) == NULL)
+        return 0;
+
+    csize = GET_SIZE(HDRP(bp));
+    fresh = GET_FRESH(HDRP(bp));
+    remainder = csize - total;
+    delete_node(heap, bp);
+
+    // Hand the tail to the last block if it is too small to split off
+    for (i = 0; i < n; i++) {
+        size_t bsize = asize;
+
+        if (i == n - 1 && remainder <= DSIZE * 2)
+            bsize += remainder;
+        if (i == 0)
+            PUT(HDRP(bp), PACK(bsize, 1));
+        else
+            PUT_NOTAG(HDRP(bp), PACK(bsize, 1));
+        PUT_NOTAG(FTRP(bp), PACK(bsize, 1));
+        out[i] = bp;
+        bp = NEXT_BLKP(bp);
+    }
+
+    if (remainder > DSIZE * 2) {
+        PUT_NOTAG(HDRP(bp), PACK(remainder, fresh));
+        PUT_NOTAG(FTRP(bp), PACK(remainder, 0));
+        insert_node(heap, bp, remainder);
+    }
+    return n;
+}
+
 /*
  * mm_free - Freeing a block does nothing.
  */
 void mm_free(void *bp)
+{
+    mm_heap_free(&default_heap, bp);
+}
+
+void mm_heap_free(mm_heap_t *heap, void *bp)
 {
     size_t size = GET_SIZE(HDRP(bp));
     
@@ -284,16 +667,136 @@ void mm_free(void *bp)
     PUT(FTRP(bp), PACK(size, 0));
 
     // insert_node(bp, size);
-    coalesce(bp);
+    coalesce(heap, bp);
 
     return;
 }
 
-static void *coalesce(void *bp)
+/*
+ * mm_free_sized - Free a block whose size the caller knows. size may be
+ *     anything from the size originally requested up to mm_usable_size().
+ *     This is a plain alias of mm_free, and size is ignored: a block can
+ *     be bigger than its request (unsplit remainder, realloc buffer) and
+ *     its header carries the reallocation tag, so the header has to be
+ *     read anyway and the caller's size saves nothing.
+ */
+void mm_free_sized(void *bp, size_t size)
+{
+    mm_heap_free(&default_heap, bp);
+}
+
+void mm_heap_free_sized(mm_heap_t *heap, void *bp, size_t size)
+{
+    mm_heap_free(heap, bp);
+}
+
+/*
+ * mm_usable_size - Return the number of payload bytes in the block at bp
+ *     that the caller may use: the whole block less header and footer.
+ *     This includes alignment rounding, unsplit remainders and the
+ *     REALLOC_BUFFER reserve left by mm_realloc.
+ */
+size_t mm_usable_size(void *bp)
+{
+    if (bp == NULL)
+        return 0;
+    return GET_SIZE(HDRP(bp)) - DSIZE;
+}
+
+/*
+ * mm_heap_stats - Count the blocks on the heap's free lists, their
+ *     total size and the largest of them. Walks every free list, so it
+ *     costs time in proportion to the number of free blocks.
+ */
+void mm_heap_stats(mm_heap_t *heap, mm_heap_stats_t *stats)
+{
+    int list;
+    char *bp;
+    size_t size;
+
+    memset(stats, 0, sizeof(*stats));
+    for (list = 0; list < LISTLIMIT; list++) {
+        for (bp = heap->segregated_free_lists[list]; bp != NULL; bp = PRED(bp)) {
+            size = GET_SIZE(HDRP(bp));
+            stats->free_blocks++;
+            stats->free_bytes += size;
+            stats->largest_free = MAX(stats->largest_free, size);
+        }
+    }
+    stats->heap_bytes = mem_heapsize_r(heap->mem);
+}
+
+/*
+ * mm_heap_walk - Call fn on every block of the heap in address order,
+ *     with its payload pointer, its whole size (header and footer
+ *     included) and whether it is allocated. The prologue and epilogue
+ *     are not blocks; fn must not allocate or free.
+ */
+void mm_heap_walk(mm_heap_t *heap, mm_walk_fn fn, void *arg)
+{
+    char *bp;
+
+    for (bp = heap->first_block; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+        fn(bp, GET_SIZE(HDRP(bp)), GET_ALLOC(HDRP(bp)), arg);
+}
+
+/*
+ * ptr_compare - qsort comparator ordering block pointers by address
+ */
+static int ptr_compare(const void *a, const void *b)
+{
+    char *p = *(char * const *)a;
+    char *q = *(char * const *)b;
+
+    return (p > q) - (p < q);
+}
+
+/*
+ * mm_free_batch - Free n blocks. The pointers are sorted by address
+ *     (BATCH_SORT at a time, in a local copy) so that each run of
+ *     adjacent blocks is merged into one free block and coalesced
+ *     and inserted once, instead of once per block.
+ */
+void mm_free_batch(void **ptrs, int n)
+{
+    mm_heap_free_batch(&default_heap, ptrs, n);
+}
+
+void mm_heap_free_batch(mm_heap_t *heap, void **ptrs, int n)
+{
+    void *sorted[BATCH_SORT];
+    int base, count, i, j;
+    char *bp;
+    size_t size;
+
+    for (base = 0; base < n; base += count) {
+        count = MIN(n - base, BATCH_SORT);
+        memcpy(sorted, ptrs + base, count * sizeof(void *));
+        qsort(sorted, count, sizeof(void *), ptr_compare);
+
+        for (i = 0; i < count; i = j) {
+            // Find the run of blocks that are adjacent in the heap
+            bp = sorted[i];
+            size = GET_SIZE(HDRP(bp));
+            for (j = i + 1; j < count && (char *)sorted[j] == bp + size; j++)
+                size += GET_SIZE(HDRP(sorted[j]));
+
+            REMOVE_RATAG(HDRP(bp + size));
+            PUT(HDRP(bp), PACK(size, 0));
+            PUT(FTRP(bp), PACK(size, 0));
+            coalesce(heap, bp);
+        }
+    }
+}
+
+static void *coalesce(mm_heap_t *heap, void *bp)
 {
     size_t prev_alloc = GET_ALLOC(HDRP(PREV_BLKP(bp)));
     size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
     size_t size = GET_SIZE(HDRP(bp));
+    size_t fresh = GET_FRESH(HDRP(bp));  // Kept only if every part is fresh
+    void *prev = PREV_BLKP(bp);
+    void *next = NEXT_BLKP(bp);
 
     // Do not coalesce with previous block if the previous block is tagged with Reallocation tag
     if (GET_TAG(HDRP(PREV_BLKP(bp))))
@@ -306,34 +809,45 @@ static void *coalesce(void *bp)
     if (prev_alloc && !next_alloc)
     {  // Case 2
         // delete_node(bp);
-        delete_node(NEXT_BLKP(bp));
-        size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        PUT(HDRP(bp), PACK(size, 0));
+        delete_node(heap, next);
+        size += GET_SIZE(HDRP(next));
+        fresh &= GET_FRESH(HDRP(next));
+        if (fresh)
+            CLEAR_SEAM(next);
+        PUT(HDRP(bp), PACK(size, fresh));
         PUT(FTRP(bp), PACK(size, 0));
     }
 
     else if (!prev_alloc && next_alloc)
     {  // Case 3
         // delete_node(bp);
-        delete_node(PREV_BLKP(bp));
-        size += GET_SIZE(HDRP(PREV_BLKP(bp)));
+        delete_node(heap, prev);
+        size += GET_SIZE(HDRP(prev));
+        fresh &= GET_FRESH(HDRP(prev));
         PUT(FTRP(bp), PACK(size, 0));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
-        bp = PREV_BLKP(bp);
+        if (fresh)
+            CLEAR_SEAM(bp);
+        PUT(HDRP(prev), PACK(size, fresh));
+        bp = prev;
     }
 
     else if (!prev_alloc && !next_alloc)
     {  // Case 4
         // delete_node(bp);
-        delete_node(PREV_BLKP(bp));
-        delete_node(NEXT_BLKP(bp));
-        size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(FTRP(NEXT_BLKP(bp)));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
-        PUT(FTRP(NEXT_BLKP(bp)), PACK(size, 0));
-        bp = PREV_BLKP(bp);
+        delete_node(heap, prev);
+        delete_node(heap, next);
+        size += GET_SIZE(HDRP(prev)) + GET_SIZE(FTRP(next));
+        fresh &= GET_FRESH(HDRP(prev)) & GET_FRESH(HDRP(next));
+        PUT(FTRP(next), PACK(size, 0));
+        if (fresh) {
+            CLEAR_SEAM(bp);
+            CLEAR_SEAM(next);
+        }
+        PUT(HDRP(prev), PACK(size, fresh));
+        bp = prev;
     }
     // add_free(bp);
-    insert_node(bp, size);
+    insert_node(heap, bp, size);
     // last_bp = bp;
     return bp;
 }
@@ -353,6 +867,11 @@ static void *coalesce(void *bp)
  *              the reallocated block is freed.
  */
 void *mm_realloc(void *ptr, size_t size)
+{
+    return mm_heap_realloc(&default_heap, ptr, size);
+}
+
+void *mm_heap_realloc(mm_heap_t *heap, void *ptr, size_t size)
 {
     void *new_ptr = ptr;  // Pointer to be returned
     size_t new_size = size;  // Size of new block
@@ -360,13 +879,13 @@ void *mm_realloc(void *ptr, size_t size)
     int extendsize;  // Size of heap extension
     int block_buffer;  // Size of block buffer
 
-    if (size == 0) {
+    if (size == 0 || size > MAX_REQUEST) {
         return NULL;
     }
 
     // Align block size
     if (new_size <= DSIZE) {
-        new_size = 2 * DSIZE;
+        new_size = MINBLOCK;
     } else {
         new_size = ALIGN(size + DSIZE);
     }
@@ -379,24 +898,29 @@ void *mm_realloc(void *ptr, size_t size)
 
     // Alocate more space if overhead falls below the minimum
     if (block_buffer < 0) {
-        // Check if next block is a free block or the epilogue block
-        if (!GET_ALLOC(HDRP(NEXT_BLKP(ptr))) || !GET_SIZE(HDRP(NEXT_BLKP(ptr)))) {
-            remainder = GET_SIZE(HDRP(ptr)) + GET_SIZE(HDRP(NEXT_BLKP(ptr))) - new_size;
+        remainder = GET_SIZE(HDRP(ptr)) + GET_SIZE(HDRP(NEXT_BLKP(ptr))) - new_size;
+
+        // Check if next block is a free block or the epilogue block, and
+        // either fits or is the last block so extending the heap helps
+        if ((!GET_ALLOC(HDRP(NEXT_BLKP(ptr))) || !GET_SIZE(HDRP(NEXT_BLKP(ptr)))) &&
+            (remainder >= 0 || !GET_SIZE(HDRP(NEXT_BLKP(NEXT_BLKP(ptr)))))) {
             if (remainder < 0) {
                 extendsize = MAX(-remainder, CHUNKSIZE);
-                if (extend_heap(extendsize) == NULL)
+                if (extend_heap(heap, extendsize) == NULL)
                     return NULL;
                 remainder += extendsize;
             }
-            delete_node(NEXT_BLKP(ptr));
+            delete_node(heap, NEXT_BLKP(ptr));
 
             // Do not split block
             PUT_NOTAG(HDRP(ptr), PACK(new_size + remainder, 1));
             PUT_NOTAG(FTRP(ptr), PACK(new_size + remainder, 1));
         } else {
-            new_ptr = mm_malloc(new_size - DSIZE);
-            memcpy(new_ptr, ptr, MIN(size, new_size));
-            mm_free(ptr);
+            // Move the old payload; on failure leave the old block alone
+            if ((new_ptr = mm_heap_malloc(heap, new_size - DSIZE)) == NULL)
+                return NULL;
+            memcpy(new_ptr, ptr, MIN(GET_SIZE(HDRP(ptr)) - DSIZE, size));
+            mm_heap_free(heap, ptr);
         }
         block_buffer = GET_SIZE(HDRP(new_ptr)) - new_size;
     }
@@ -408,12 +932,13 @@ void *mm_realloc(void *ptr, size_t size)
     return new_ptr;
 }
 
-static void *place(void *bp, size_t asize)
+static void *place(mm_heap_t *heap, void *bp, size_t asize)
 {
     size_t csize = GET_SIZE(HDRP(bp));
     size_t remainder = csize - asize;
+    size_t fresh = GET_FRESH(HDRP(bp));  // The remainder stays fresh
 
-    delete_node(bp);
+    delete_node(heap, bp);
 
     if (remainder <= DSIZE * 2) {
         // Do not split block
@@ -423,11 +948,11 @@ static void *place(void *bp, size_t asize)
 
     else if (asize >= 100) {
         // Split block
-        PUT(HDRP(bp), PACK(remainder, 0));
+        PUT(HDRP(bp), PACK(remainder, fresh));
         PUT(FTRP(bp), PACK(remainder, 0));
         PUT_NOTAG(HDRP(NEXT_BLKP(bp)), PACK(asize, 1));
         PUT_NOTAG(FTRP(NEXT_BLKP(bp)), PACK(asize, 1));
-        insert_node(bp, remainder);
+        insert_node(heap, bp, remainder);
         return NEXT_BLKP(bp);
     }
 
@@ -435,9 +960,9 @@ static void *place(void *bp, size_t asize)
         // Split block
         PUT(HDRP(bp), PACK(asize, 1));
         PUT(FTRP(bp), PACK(asize, 1));
-        PUT_NOTAG(HDRP(NEXT_BLKP(bp)), PACK(remainder, 0));
+        PUT_NOTAG(HDRP(NEXT_BLKP(bp)), PACK(remainder, fresh));
         PUT_NOTAG(FTRP(NEXT_BLKP(bp)), PACK(remainder, 0));
-        insert_node(NEXT_BLKP(bp), remainder);
+        insert_node(heap, NEXT_BLKP(bp), remainder);
     }
     return bp;
 }
@@ -1,10 +1,113 @@
+#ifndef __MM_H_
+#define __MM_H_
+
 #include <stdio.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern int mm_init (void);
 extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
 
+/*
+ * Compile-time fast path. When the size is a compile-time constant,
+ * mm_malloc_fixed() folds the block size and the segregated list to
+ * search first into constants and calls mm_malloc_class() directly;
+ * other sizes go through mm_malloc(). The macros mirror the block
+ * layout in mm.c: 4-byte header and footer, 16-byte minimum block.
+ *
+ * The block sizes depend on MM_ALIGNMENT, which must be the one mm.o
+ * was built with, so the class entry points carry it in their link
+ * names: a file built with another -DALIGNMENT fails to link against
+ * mm.o (undefined mm_malloc_class_a16, say) instead of getting wrong
+ * sizes. Sizes above MM_MAX_REQUEST, which every entry point refuses,
+ * take the mm_malloc() path too.
+ */
+#ifndef MM_ALIGNMENT
+#ifdef ALIGNMENT
+#define MM_ALIGNMENT ALIGNMENT
+#else
+#define MM_ALIGNMENT 8
+#endif
+#endif
+#define MM_MAX_REQUEST ((size_t)1 << 30)
+#define MM_CAT2(a, b) a##b
+#define MM_CAT(a, b) MM_CAT2(a, b)
+#define mm_malloc_class MM_CAT(mm_malloc_class_a, MM_ALIGNMENT)
+#define mm_heap_malloc_class MM_CAT(mm_heap_malloc_class_a, MM_ALIGNMENT)
+#define MM_LISTLIMIT 20
+#define MM_ALIGN(size) \
+    (((size) + (MM_ALIGNMENT-1)) & ~(size_t)(MM_ALIGNMENT-1))
+#define MM_OVERHEAD 8  /* header and footer of a block */
+#define MM_BLOCK_SIZE(size) \
+    ((size) <= 8 ? MM_ALIGN(16) : MM_ALIGN((size) + MM_OVERHEAD))
+#define MM_LOG2(x) (31 - __builtin_clz((unsigned int)(x)))
+#define MM_SIZE_CLASS(asize) \
+    (MM_LOG2(asize) < MM_LISTLIMIT - 1 ? MM_LOG2(asize) : MM_LISTLIMIT - 1)
+
+extern void *mm_malloc_class(size_t asize, int list);
+
+static inline void *mm_malloc_fixed(size_t size)
+{
+    if (__builtin_constant_p(size) && size != 0 && size <= MM_MAX_REQUEST)
+        return mm_malloc_class(MM_BLOCK_SIZE(size), 
+                               MM_SIZE_CLASS(MM_BLOCK_SIZE(size)));
+    return mm_malloc(size);
+}
+
+/* Allocate a zeroed array of nmemb elements */
+extern void *mm_calloc(size_t nmemb, size_t size);
+
+/* Allocate with a payload aligned to align (a power of 2) bytes */
+extern void *mm_memalign(size_t align, size_t size);
+extern void *mm_aligned_alloc(size_t align, size_t size);
+
+/* Sized free, and the real capacity of a block */
+extern void mm_free_sized(void *ptr, size_t size);
+extern size_t mm_usable_size(void *ptr);
+
+/* Allocate or free n blocks at once */
+extern int mm_malloc_batch(size_t size, int n, void **out);
+extern void mm_free_batch(void **ptrs, int n);
+
+/*
+ * Independent heaps. Each heap owns its free lists and its own memlib
+ * heap; mm_heap_destroy() releases every block in it at once. The
+ * functions above operate on a default heap set up by mm_init().
+ */
+typedef struct mm_heap mm_heap_t;
+
+extern mm_heap_t *mm_heap_create(size_t max_size);
+extern mm_heap_t *mm_default_heap(void);
+extern void *mm_heap_malloc(mm_heap_t *heap, size_t size);
+extern void *mm_heap_malloc_class(mm_heap_t *heap, size_t asize, int list);
+extern void mm_heap_free(mm_heap_t *heap, void *ptr);
+extern void mm_heap_free_sized(mm_heap_t *heap, void *ptr, size_t size);
+extern void *mm_heap_calloc(mm_heap_t *heap, size_t nmemb, size_t size);
+extern void *mm_heap_memalign(mm_heap_t *heap, size_t align, size_t size);
+extern void *mm_heap_realloc(mm_heap_t *heap, void *ptr, size_t size);
+extern int mm_heap_malloc_batch(mm_heap_t *heap, size_t size, int n, 
+                                void **out);
+extern void mm_heap_free_batch(mm_heap_t *heap, void **ptrs, int n);
+extern void mm_heap_destroy(mm_heap_t *heap);
+
+/* The state of a heap's free lists, for the driver's heap reports */
+typedef struct {
+    size_t heap_bytes;    /* size of the heap */
+    size_t free_blocks;   /* blocks on the free lists */
+    size_t free_bytes;    /* their total size, headers and footers included */
+    size_t largest_free;  /* size of the largest of them */
+} mm_heap_stats_t;
+
+extern void mm_heap_stats(mm_heap_t *heap, mm_heap_stats_t *stats);
+
+/* Walk every block of a heap in address order; size includes overhead */
+typedef void (*mm_walk_fn)(void *bp, size_t size, int alloc, void *arg);
+extern void mm_heap_walk(mm_heap_t *heap, mm_walk_fn fn, void *arg);
+
 
 /* 
  * Students work in teams of one or two.  Teams enter their team name, 
@@ -21,3 +124,8 @@ typedef struct {
 
 extern team_t team;
 
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MM_H_ */
@@ -0,0 +1,135 @@
+#ifndef __MM_CXX_H_
+#define __MM_CXX_H_
+
+/*
+ * mm_cxx.h - C++ access to mm heaps
+ *
+ * mm_memory_resource is a std::pmr::memory_resource over an mm heap,
+ * and mm_allocator<T> is an STL allocator over one. Either can use an
+ * existing heap, such as mm_default_heap() once mem_init() and
+ * mm_init() have run, or the resource can own a heap of its own that
+ * it releases in one go when destroyed. Like the heaps themselves,
+ * neither is synchronized.
+ *
+ * mm_new.cc holds the opt-in replacements for global operator new and
+ * delete; link it in to route every new/delete to mm_malloc/mm_free.
+ */
+#include <cstddef>
+#include <new>
+#include <memory_resource>
+
+#include "mm.h"
+
+/*
+ * mm_allocate - allocate bytes aligned to align from heap, or NULL
+ */
+inline void *mm_allocate(mm_heap_t *heap, std::size_t bytes,
+                         std::size_t align)
+{
+    if (bytes == 0)
+        bytes = 1;
+    if (align > MM_ALIGNMENT)
+        return mm_heap_memalign(heap, align, bytes);
+    return mm_heap_malloc(heap, bytes);
+}
+
+class mm_memory_resource : public std::pmr::memory_resource {
+public:
+    /* Allocate from an existing heap */
+    explicit mm_memory_resource(mm_heap_t *heap)
+        : heap_(heap), owned_(false) {}
+
+    /* Allocate from a new heap of at most max_size bytes */
+    explicit mm_memory_resource(std::size_t max_size)
+        : heap_(mm_heap_create(max_size)), owned_(true)
+    {
+        if (heap_ == NULL)
+            throw std::bad_alloc();
+    }
+
+    mm_memory_resource(const mm_memory_resource &) = delete;
+    mm_memory_resource &operator=(const mm_memory_resource &) = delete;
+
+    ~mm_memory_resource()
+    {
+        if (owned_)
+            mm_heap_destroy(heap_);
+    }
+
+    mm_heap_t *heap() const { return heap_; }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t align) override
+    {
+        void *p = mm_allocate(heap_, bytes, align);
+
+        if (p == NULL)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t) override
+    {
+        mm_heap_free_sized(heap_, p, bytes ? bytes : 1);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override
+    {
+        const mm_memory_resource *r =
+            dynamic_cast<const mm_memory_resource *>(&other);
+
+        return r != NULL && r->heap_ == heap_;
+    }
+
+private:
+    mm_heap_t *heap_;
+    bool owned_;  // heap_ was made by us and dies with us
+};
+
+template <class T>
+class mm_allocator {
+public:
+    typedef T value_type;
+
+    explicit mm_allocator(mm_heap_t *heap) noexcept : heap_(heap) {}
+
+    template <class U>
+    mm_allocator(const mm_allocator<U> &other) noexcept
+        : heap_(other.heap()) {}
+
+    T *allocate(std::size_t n)
+    {
+        void *p;
+
+        if (n > (std::size_t)-1 / sizeof(T))
+            throw std::bad_array_new_length();
+        if ((p = mm_allocate(heap_, n * sizeof(T), alignof(T))) == NULL)
+            throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        mm_heap_free_sized(heap_, p, n ? n * sizeof(T) : 1);
+    }
+
+    mm_heap_t *heap() const noexcept { return heap_; }
+
+private:
+    mm_heap_t *heap_;
+};
+
+template <class T, class U>
+bool operator==(const mm_allocator<T> &a, const mm_allocator<U> &b) noexcept
+{
+    return a.heap() == b.heap();
+}
+
+template <class T, class U>
+bool operator!=(const mm_allocator<T> &a, const mm_allocator<U> &b) noexcept
+{
+    return a.heap() != b.heap();
+}
+
+#endif /* __MM_CXX_H_ */
@@ -0,0 +1,182 @@
+/*
+ * mm_new.cc - opt-in replacements for the global operator new and
+ *     delete. Linking this file into a program routes every new and
+ *     delete expression to the mm default heap: plain and array forms,
+ *     nothrow forms, aligned forms (mm_memalign) and sized deletes
+ *     (mm_free_sized). Programs that don't link it keep the default
+ *     new and delete.
+ *
+ *     The heap is set up on the first allocation, which may happen
+ *     during static initialization, and one mutex serializes calls
+ *     into mm.c, as in libmm.c.
+ */
+#include <cstddef>
+#include <new>
+#include <mutex>
+
+#include "mm.h"
+#include "memlib.h"
+
+/* private variables */
+static std::mutex mm_lock;  /* constexpr-constructed: safe before main */
+static bool mm_ready = false;
+
+/*
+ * new_block - allocate size bytes aligned to align, or NULL
+ */
+static void *new_block(std::size_t size, std::size_t align)
+{
+    std::lock_guard<std::mutex> guard(mm_lock);
+
+    if (!mm_ready) {
+        mem_init();
+        if (mm_init() < 0)
+            return NULL;
+        mm_ready = true;
+    }
+    if (size == 0)
+        size = 1;
+    if (align > MM_ALIGNMENT)
+        return mm_memalign(align, size);
+    return mm_malloc(size);
+}
+
+/*
+ * new_or_throw - new_block that calls the new handler and retries, then
+ *     throws std::bad_alloc, as the standard operator new does
+ */
+static void *new_or_throw(std::size_t size, std::size_t align)
+{
+    void *p;
+
+    while ((p = new_block(size, align)) == NULL) {
+        std::new_handler handler = std::get_new_handler();
+
+        if (handler == NULL)
+            throw std::bad_alloc();
+        handler();
+    }
+    return p;
+}
+
+static void delete_block(void *p)
+{
+    if (p == NULL)
+        return;
+    std::lock_guard<std::mutex> guard(mm_lock);
+    mm_free(p);
+}
+
+static void delete_sized(void *p, std::size_t size)
+{
+    if (p == NULL)
+        return;
+    std::lock_guard<std::mutex> guard(mm_lock);
+    mm_free_sized(p, size ? size : 1);
+}
+
+/* Plain and array forms */
+void *operator new(std::size_t size)
+{
+    return new_or_throw(size, 0);
+}
+
+void *operator new[](std::size_t size)
+{
+    return new_or_throw(size, 0);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return new_block(size, 0);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return new_block(size, 0);
+}
+
+void operator delete(void *p) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete(void *p, std::size_t size) noexcept
+{
+    delete_sized(p, size);
+}
+
+void operator delete[](void *p, std::size_t size) noexcept
+{
+    delete_sized(p, size);
+}
+
+/* Aligned forms */
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    return new_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    return new_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void *operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t &) noexcept
+{
+    return new_block(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t &) noexcept
+{
+    return new_block(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept
+{
+    delete_block(p);
+}
+
+void operator delete(void *p, std::size_t size, std::align_val_t) noexcept
+{
+    delete_sized(p, size);
+}
+
+void operator delete[](void *p, std::size_t size, std::align_val_t) noexcept
+{
+    delete_sized(p, size);
+}
@@ -0,0 +1,554 @@
+/*
+ * mmtrace.c - record the malloc family calls of a running program as
+ *     a balanced .rep trace that mdriver can replay. Built as
+ *     libmmtrace.so ("make libmmtrace.so") and loaded with LD_PRELOAD:
+ *
+ *         unix> MMTRACE_FILE=svc.rep LD_PRELOAD=./libmmtrace.so ./svc
+ *         unix> mdriver -V -f svc.rep
+ *
+ *     Every call is forwarded to the glibc allocator through its
+ *     __libc_* entry points, so there is no dlsym() lookup to bootstrap.
+ *     Each call is also appended as an event to a buffer owned by the
+ *     calling thread. Threads never share a buffer and never take a
+ *     lock: the only shared write is an atomic sequence number that
+ *     puts the events of all threads in one order. A free is numbered
+ *     before the block is released and an allocation after the block is
+ *     obtained, so an address is never seen live twice.
+ *
+ *     When the program exits, the events are replayed in sequence
+ *     order. Each live address gets a request id, and blocks still live
+ *     at the end get a closing free, so the output is a balanced trace.
+ *     Frees of blocks allocated before recording started are dropped.
+ *
+ *     Environment variables:
+ *         MMTRACE_FILE   output trace (default mmtrace.<pid>.rep)
+ *         MMTRACE_TIMES  if set, also write <file>.times: one
+ *                        "<tid> <nanoseconds>" line per recorded
+ *                        request
+ *
+ *     The trace is written by an exit handler, so a program that ends
+ *     in _exit() or on a signal leaves no trace.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define EXPORT __attribute__((visibility("default")))
+#define TLS    __thread __attribute__((tls_model("initial-exec")))
+
+#define CHUNK_EVENTS 65536        /* events per thread buffer */
+#define PEND_TAG     (1UL << 63)  /* marks a pending realloc's key */
+#define MAX_BYTES    0x7fffffffUL /* largest size a .rep line can hold */
+
+/* The glibc allocator */
+extern void *__libc_malloc(size_t size);
+extern void __libc_free(void *ptr);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+
+/* Event types */
+enum {
+    EV_NONE = 0,  /* slot whose event was never written */
+    EV_MALLOC,    /* ptr = malloc(size) */
+    EV_CALLOC,    /* ptr = calloc(arg, size) */
+    EV_MEMALIGN,  /* ptr = memalign(arg, size) */
+    EV_FREE,      /* free(ptr) */
+    EV_RBEGIN,    /* realloc(ptr, ...) entered */
+    EV_REND,      /* ptr = realloc(..., size) returned; arg = RBEGIN seq */
+    EV_RFAIL      /* realloc(ptr, ...) failed; arg = RBEGIN seq */
+};
+
+typedef struct {
+    unsigned long seq;   /* global order */
+    unsigned long ptr;
+    size_t size;
+    size_t arg;
+    unsigned long ns;    /* CLOCK_MONOTONIC, if MMTRACE_TIMES is set */
+    int tid;
+    int type;
+} event_t;
+
+/* A buffer of events written by one thread */
+typedef struct chunk {
+    struct chunk *next;  /* all chunks, newest first */
+    unsigned long n;     /* events written, published with release */
+    event_t ev[CHUNK_EVENTS];
+} chunk_t;
+
+/* A live address in the replay */
+typedef struct {
+    unsigned long key;   /* address, or PEND_TAG|seq; 0 if empty */
+    unsigned id;
+    size_t size;
+} slot_t;
+
+typedef struct {
+    slot_t *slots;
+    unsigned long mask;  /* number of slots - 1 */
+    unsigned long used;
+} table_t;
+
+/* private variables */
+static chunk_t *chunks;          /* every thread's buffers */
+static unsigned long next_seq;
+static int done;                 /* set when the trace is being written */
+static int want_times;
+static TLS chunk_t *my_chunk;
+static TLS int my_tid;
+
+/*
+ * map - zeroed storage that doesn't come from malloc, or NULL
+ */
+static void *map(size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    return (p == MAP_FAILED) ? NULL : p;
+}
+
+/*
+ * next_event - number and return the calling thread's next event slot,
+ *     or NULL if the event can't be recorded
+ */
+static event_t *next_event(void)
+{
+    chunk_t *c = my_chunk;
+    event_t *ev;
+
+    if (__atomic_load_n(&done, __ATOMIC_RELAXED))
+	return NULL;
+    if (c == NULL || c->n == CHUNK_EVENTS) {
+	if ((c = map(sizeof(chunk_t))) == NULL)
+	    return NULL;
+	c->next = __atomic_load_n(&chunks, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&chunks, &c->next, c, 1,
+					    __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+	    ;
+	my_chunk = c;
+	if (my_tid == 0)
+	    my_tid = syscall(SYS_gettid);
+    }
+    ev = &c->ev[c->n];
+    ev->seq = __atomic_fetch_add(&next_seq, 1, __ATOMIC_RELAXED);
+    return ev;
+}
+
+/*
+ * record - fill in and publish an event from next_event()
+ */
+static void record(event_t *ev, int type, void *ptr, size_t size,
+		   size_t arg)
+{
+    struct timespec ts;
+
+    if (ev == NULL)
+	return;
+    ev->type = type;
+    ev->ptr = (unsigned long)ptr;
+    ev->size = size;
+    ev->arg = arg;
+    ev->tid = my_tid;
+    ev->ns = 0;
+    if (want_times) {
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ev->ns = ts.tv_sec * 1000000000UL + ts.tv_nsec;
+    }
+    __atomic_store_n(&my_chunk->n, my_chunk->n + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * The exported malloc family
+ */
+EXPORT void *malloc(size_t size)
+{
+    void *p = __libc_malloc(size);
+
+    if (p != NULL)
+	record(next_event(), EV_MALLOC, p, size, 0);
+    return p;
+}
+
+EXPORT void free(void *ptr)
+{
+    if (ptr != NULL)
+	record(next_event(), EV_FREE, ptr, 0, 0);
+    __libc_free(ptr);
+}
+
+EXPORT void *realloc(void *ptr, size_t size)
+{
+    event_t *begin;
+    unsigned long seq = 0;
+    void *p;
+
+    if (ptr == NULL)
+	return malloc(size);
+    if ((begin = next_event()) != NULL)
+	seq = begin->seq;
+    record(begin, EV_RBEGIN, ptr, 0, 0);
+    p = __libc_realloc(ptr, size);
+    if (begin == NULL)
+	return p;
+    if (p == NULL && size != 0)
+	record(next_event(), EV_RFAIL, ptr, 0, seq);
+    else
+	record(next_event(), EV_REND, p, size, seq);
+    return p;
+}
+
+EXPORT void *calloc(size_t nmemb, size_t size)
+{
+    void *p = __libc_calloc(nmemb, size);
+
+    if (p != NULL)
+	record(next_event(), EV_CALLOC, p, size, nmemb);
+    return p;
+}
+
+/*
+ * aligned - the memalign family. Returns NULL with errno set on failure.
+ */
+static void *aligned(size_t align, size_t size)
+{
+    void *p;
+
+    if (align == 0 || (align & (align - 1)) != 0) {
+	errno = EINVAL;
+	return NULL;
+    }
+    if ((p = __libc_memalign(align, size)) != NULL)
+	record(next_event(), EV_MEMALIGN, p, size, align);
+    return p;
+}
+
+EXPORT int posix_memalign(void **memptr, size_t align, size_t size)
+{
+    void *p;
+
+    if (align % sizeof(void *) != 0 || (align & (align - 1)) != 0)
+	return EINVAL;
+    if ((p = aligned(align, size)) == NULL)
+	return ENOMEM;
+    *memptr = p;
+    return 0;
+}
+
+EXPORT void *aligned_alloc(size_t align, size_t size)
+{
+    return aligned(align, size);
+}
+
+EXPORT void *memalign(size_t align, size_t size)
+{
+    return aligned(align, size);
+}
+
+EXPORT void *valloc(size_t size)
+{
+    return aligned(sysconf(_SC_PAGESIZE), size);
+}
+
+EXPORT void *pvalloc(size_t size)
+{
+    size_t pagesize = sysconf(_SC_PAGESIZE);
+
+    return aligned(pagesize, (size + pagesize - 1) & ~(pagesize - 1));
+}
+
+/*
+ * Address table for the replay: linear probing, grown at half full
+ */
+static unsigned long hash(unsigned long key)
+{
+    return (key * 0x9e3779b97f4a7c15UL) >> 20;
+}
+
+static int table_grow(table_t *t)
+{
+    unsigned long n = t->slots ? 2 * (t->mask + 1) : 1 << 16;
+    slot_t *old = t->slots;
+    unsigned long i, j, old_n = t->slots ? t->mask + 1 : 0;
+
+    if ((t->slots = map(n * sizeof(slot_t))) == NULL)
+	return -1;
+    t->mask = n - 1;
+    for (i = 0; i < old_n; i++) {
+	if (old[i].key == 0)
+	    continue;
+	for (j = hash(old[i].key) & t->mask; t->slots[j].key;
+	     j = (j + 1) & t->mask)
+	    ;
+	t->slots[j] = old[i];
+    }
+    if (old != NULL)
+	munmap(old, old_n * sizeof(slot_t));
+    return 0;
+}
+
+static slot_t *table_find(table_t *t, unsigned long key)
+{
+    unsigned long i;
+
+    for (i = hash(key) & t->mask; t->slots[i].key; i = (i + 1) & t->mask)
+	if (t->slots[i].key == key)
+	    return &t->slots[i];
+    return NULL;
+}
+
+static int table_put(table_t *t, unsigned long key, unsigned id,
+		     size_t size)
+{
+    unsigned long i;
+
+    if (2 * (t->used + 1) > t->mask + 1 && table_grow(t) < 0)
+	return -1;
+    for (i = hash(key) & t->mask; t->slots[i].key; i = (i + 1) & t->mask)
+	;
+    t->slots[i].key = key;
+    t->slots[i].id = id;
+    t->slots[i].size = size;
+    t->used++;
+    return 0;
+}
+
+/*
+ * table_remove - remove slot s, shifting later entries of its probe
+ *     run back so that no lookup stops short at the hole
+ */
+static void table_remove(table_t *t, slot_t *s)
+{
+    unsigned long i = s - t->slots, j = i, home;
+
+    for (;;) {
+	j = (j + 1) & t->mask;
+	if (t->slots[j].key == 0)
+	    break;
+	home = hash(t->slots[j].key) & t->mask;
+	if (((j - home) & t->mask) >= ((j - i) & t->mask)) {
+	    t->slots[i] = t->slots[j];
+	    i = j;
+	}
+    }
+    t->slots[i].key = 0;
+    t->used--;
+}
+
+/* State of the replay that writes the trace */
+typedef struct {
+    FILE *rep;
+    FILE *times;
+    table_t live;
+    unsigned ids;           /* request ids handed out */
+    unsigned ops;           /* request lines written */
+    size_t live_bytes;
+    size_t peak_bytes;
+} writer_t;
+
+/*
+ * emit_time - write the tid and timestamp of the request just written
+ */
+static void emit_time(writer_t *w, event_t *ev)
+{
+    w->ops++;
+    if (w->times != NULL)
+	fprintf(w->times, "%d %lu\n", ev->tid, ev->ns);
+}
+
+/*
+ * bind - give address ev->ptr the request id id
+ */
+static void bind(writer_t *w, event_t *ev, unsigned id, size_t size)
+{
+    table_put(&w->live, ev->ptr, id, size);
+    w->live_bytes += size;
+    if (w->live_bytes > w->peak_bytes)
+	w->peak_bytes = w->live_bytes;
+}
+
+/*
+ * replay - write the trace line for one event
+ */
+static void replay(writer_t *w, event_t *ev)
+{
+    size_t size = ev->size ? ev->size : 1;
+    slot_t *s;
+    unsigned id;
+
+    switch (ev->type) {
+    case EV_MALLOC:
+    case EV_CALLOC:
+    case EV_MEMALIGN:
+	if (ev->size > MAX_BYTES || table_find(&w->live, ev->ptr) != NULL)
+	    return;
+	/* A calloc whose total the trace can't hold, before it takes an id */
+	if (ev->type == EV_CALLOC && ev->size != 0 &&
+	    ev->arg > MAX_BYTES / ev->size)
+	    return;
+	id = w->ids++;
+	if (ev->type == EV_MALLOC)
+	    fprintf(w->rep, "a %u %lu\n", id, (unsigned long)size);
+	else if (ev->type == EV_MEMALIGN)
+	    fprintf(w->rep, "m %u %lu %lu\n", id, (unsigned long)ev->arg,
+		    (unsigned long)size);
+	else if (ev->size == 0 || ev->arg == 0)
+	    fprintf(w->rep, "c %u 1 1\n", id);
+	else
+	    fprintf(w->rep, "c %u %lu %lu\n", id, (unsigned long)ev->arg,
+		    (unsigned long)ev->size);
+	emit_time(w, ev);
+	bind(w, ev, id, (ev->type == EV_CALLOC) ? ev->arg * size : size);
+	break;
+
+    case EV_FREE:
+	if ((s = table_find(&w->live, ev->ptr)) == NULL)
+	    return;
+	fprintf(w->rep, "f %u\n", s->id);
+	emit_time(w, ev);
+	w->live_bytes -= s->size;
+	table_remove(&w->live, s);
+	break;
+
+    case EV_RBEGIN:
+	/* Release the old address now; realloc's result comes later */
+	if ((s = table_find(&w->live, ev->ptr)) == NULL)
+	    return;
+	id = s->id;
+	size = s->size;
+	table_remove(&w->live, s);
+	table_put(&w->live, PEND_TAG | ev->seq, id, size);
+	w->live_bytes -= size;
+	break;
+
+    case EV_REND:
+	if ((s = table_find(&w->live, PEND_TAG | ev->arg)) == NULL) {
+	    /* realloc of a block we never saw: a fresh allocation */
+	    ev->type = EV_MALLOC;
+	    if (ev->ptr != 0)
+		replay(w, ev);
+	    return;
+	}
+	id = s->id;
+	size = s->size;
+	table_remove(&w->live, s);
+	if ((ev->ptr == 0 && ev->size == 0) || ev->size > MAX_BYTES) {
+	    /* realloc(ptr, 0) freed the block, or it grew past what the
+	       trace can hold and leaves the trace here */
+	    fprintf(w->rep, "f %u\n", id);
+	    emit_time(w, ev);
+	    return;
+	}
+	fprintf(w->rep, "r %u %lu\n", id, (unsigned long)ev->size);
+	emit_time(w, ev);
+	bind(w, ev, id, ev->size);
+	break;
+
+    case EV_RFAIL:
+	/* The old block is still live at its old address */
+	if ((s = table_find(&w->live, PEND_TAG | ev->arg)) == NULL)
+	    return;
+	id = s->id;
+	size = s->size;
+	table_remove(&w->live, s);
+	bind(w, ev, id, size);
+	break;
+    }
+}
+
+/*
+ * open_out - open the output trace and, if asked for, the times file
+ */
+static int open_out(writer_t *w)
+{
+    char path[4096], times[4096 + 8];
+    const char *file = getenv("MMTRACE_FILE");
+
+    if (file == NULL || *file == '\0') {
+	snprintf(path, sizeof(path), "mmtrace.%d.rep", (int)getpid());
+	file = path;
+    }
+    if ((w->rep = fopen(file, "w")) == NULL) {
+	fprintf(stderr, "mmtrace: can't open %s\n", file);
+	return -1;
+    }
+    if (want_times) {
+	snprintf(times, sizeof(times), "%s.times", file);
+	if ((w->times = fopen(times, "w")) == NULL)
+	    fprintf(stderr, "mmtrace: can't open %s\n", times);
+    }
+    return 0;
+}
+
+/*
+ * mmtrace_init - read the options when the library is loaded. Calls
+ *     made earlier are recorded without timestamps.
+ */
+__attribute__((constructor))
+static void mmtrace_init(void)
+{
+    want_times = (getenv("MMTRACE_TIMES") != NULL);
+}
+
+/*
+ * mmtrace_write - stop recording and write the trace. The events are
+ *     placed by sequence number, which leaves an empty slot for any
+ *     event a thread numbered but had not finished when recording
+ *     stopped.
+ */
+__attribute__((destructor))
+static void mmtrace_write(void)
+{
+    writer_t w;
+    unsigned long nseq, i;
+    event_t **order;
+    chunk_t *c;
+
+    __atomic_store_n(&done, 1, __ATOMIC_SEQ_CST);
+    nseq = __atomic_load_n(&next_seq, __ATOMIC_SEQ_CST);
+
+    memset(&w, 0, sizeof(w));
+    if (open_out(&w) < 0)
+	return;
+    if ((order = map((nseq + 1) * sizeof(event_t *))) == NULL ||
+	table_grow(&w.live) < 0) {
+	fprintf(stderr, "mmtrace: out of memory\n");
+	fclose(w.rep);
+	return;
+    }
+    for (c = __atomic_load_n(&chunks, __ATOMIC_ACQUIRE); c; c = c->next) {
+	unsigned long n = __atomic_load_n(&c->n, __ATOMIC_ACQUIRE);
+
+	for (i = 0; i < n; i++)
+	    if (c->ev[i].seq < nseq)
+		order[c->ev[i].seq] = &c->ev[i];
+    }
+
+    /* Header, rewritten with the real counts at the end */
+    fprintf(w.rep, "%20d\n%20d\n%20d\n%d\n", 0, 0, 0, 1);
+    for (i = 0; i < nseq; i++)
+	if (order[i] != NULL)
+	    replay(&w, order[i]);
+
+    /* Balance the trace, freeing reallocs cut short by the exit too */
+    for (i = 0; i <= w.live.mask; i++) {
+	slot_t *s = &w.live.slots[i];
+
+	if (s->key != 0) {
+	    fprintf(w.rep, "f %u\n", s->id);
+	    w.ops++;
+	}
+    }
+    rewind(w.rep);
+    fprintf(w.rep, "%20lu\n%20u\n%20u\n", (unsigned long)w.peak_bytes,
+	    w.ids, w.ops);
+    fclose(w.rep);
+    if (w.times != NULL)
+	fclose(w.times);
+}
@@ -0,0 +1,157 @@
+/*
+ * perfctr.c - hardware performance counters; see perfctr.h
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfctr.h"
+
+static const char *names[PERF_NUM] = {
+    "instrs", "cycles", "L1dmiss", "LLCmiss", "dTLBmiss", "brmiss", "faults"
+};
+
+static int fds[PERF_NUM] = {-1, -1, -1, -1, -1, -1, -1};
+static int first_errno;   /* why the first counter that failed did */
+
+#ifdef __linux__
+
+#define CACHE_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/* The type and config of each counter */
+static const struct {
+    unsigned type;
+    unsigned long long config;
+} events[PERF_NUM] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+/*
+ * perf_open - open the counters, disabled; returns how many opened
+ */
+int perf_open(void)
+{
+    struct perf_event_attr attr;
+    int i, n = 0;
+
+    for (i = 0; i < PERF_NUM; i++) {
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = events[i].type;
+	attr.config = events[i].config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+	    PERF_FORMAT_TOTAL_TIME_RUNNING;
+	fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if (fds[i] >= 0)
+	    n++;
+	else if (first_errno == 0)
+	    first_errno = errno;
+    }
+    return n;
+}
+
+/*
+ * perf_start - zero and enable the open counters
+ */
+void perf_start(void)
+{
+    int i;
+
+    for (i = 0; i < PERF_NUM; i++) {
+	if (fds[i] >= 0) {
+	    ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+	    ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+    }
+}
+
+/*
+ * perf_stop - disable the counters and read them into counts, scaled
+ *     up if the kernel had to multiplex them; -1 for those not open
+ */
+void perf_stop(double *counts)
+{
+    unsigned long long v[3];   /* value, time enabled, time running */
+    int i;
+
+    for (i = 0; i < PERF_NUM; i++)
+	if (fds[i] >= 0)
+	    ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    for (i = 0; i < PERF_NUM; i++) {
+	counts[i] = -1;
+	if (fds[i] < 0 || read(fds[i], v, sizeof(v)) != sizeof(v))
+	    continue;
+	counts[i] = (v[2] > 0 && v[2] < v[1]) ? (double)v[0] * v[1] / v[2]
+	    : (double)v[0];
+    }
+}
+
+#else /* !__linux__ */
+
+int perf_open(void)
+{
+    first_errno = ENOSYS;
+    return 0;
+}
+
+void perf_start(void)
+{
+}
+
+void perf_stop(double *counts)
+{
+    int i;
+
+    for (i = 0; i < PERF_NUM; i++)
+	counts[i] = -1;
+}
+
+#endif /* __linux__ */
+
+/*
+ * perf_close - close the counters
+ */
+void perf_close(void)
+{
+    int i;
+
+    for (i = 0; i < PERF_NUM; i++) {
+	if (fds[i] >= 0)
+	    close(fds[i]);
+	fds[i] = -1;
+    }
+}
+
+/*
+ * perf_name - the short name of counter i, for table headers
+ */
+const char *perf_name(int i)
+{
+    return names[i];
+}
+
+/*
+ * perf_error - why the first counter that failed to open did
+ */
+const char *perf_error(void)
+{
+    return first_errno ? strerror(first_errno) : "no error";
+}
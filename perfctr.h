@@ -0,0 +1,23 @@
+/*
+ * perfctr.h - hardware performance counters through perf_event_open(2)
+ *
+ * Each counter is opened on its own, counting user mode only, so that
+ * the ones the CPU, the kernel or a container refuses are left out and
+ * the rest still work. Where none are available, perf_open() returns 0
+ * and the others do nothing.
+ */
+#ifndef __PERFCTR_H_
+#define __PERFCTR_H_
+
+/* The counters, in the order perf_stop() reports them */
+enum {PERF_INSTRS, PERF_CYCLES, PERF_L1D_MISSES, PERF_LLC_MISSES,
+      PERF_DTLB_MISSES, PERF_BRANCH_MISSES, PERF_FAULTS, PERF_NUM};
+
+int perf_open(void);
+const char *perf_name(int i);
+const char *perf_error(void);
+void perf_start(void);
+void perf_stop(double *counts);
+void perf_close(void);
+
+#endif /* __PERFCTR_H_ */
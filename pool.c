@@ -0,0 +1,282 @@
+/*
+ * pool.c - fixed-size object pools
+ *
+ * Each pool carves objects of a single size out of page-sized chunks
+ * taken from the default mm heap. Objects carry no header: a free
+ * object's first word links it into the pool's LIFO free list, so
+ * alloc and free are a pointer pop and push. New chunks are carved
+ * lazily with a bump pointer. Chunks are only returned to the heap
+ * when the pool is destroyed.
+ *
+ * When built with -DMM_THREADS, the shared state is protected by a
+ * mutex and each pool keeps a small magazine of objects per thread
+ * slot, so most alloc/free calls don't touch the lock. A thread moves
+ * half a magazine at a time to or from the shared free list. Threads
+ * beyond MAG_THREADS share slots; a thread that finds its magazine
+ * busy falls back to the shared free list. Objects left in the
+ * magazine of an exited thread are reclaimed by mm_pool_destroy()
+ * along with their chunks. Pools serialize their own calls into the
+ * mm heap, but the heap is not otherwise thread safe.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef MM_THREADS
+#include <pthread.h>
+#endif
+
+#include "pool.h"
+#include "mm.h"
+#include "memlib.h"
+
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+
+/* rounds size up to a multiple of align (a power of 2) */
+#define ALIGN_UP(size, align) (((size) + ((align)-1)) & ~((size_t)(align)-1))
+
+#define POOL_MINOBJS 8       /* Objects per chunk, at least */
+#define BLOCK_OVERHEAD 8     /* mm header + footer of each chunk */
+
+#ifdef MM_THREADS
+#define MAG_SIZE 32          /* Objects cached per thread and pool */
+#define MAG_THREADS 16       /* Thread slots (magazines) per pool */
+#endif
+
+/* Next object on a free list (the object's first word) */
+#define NEXT_OBJ(obj) (*(void **)(obj))
+
+#ifdef MM_THREADS
+/* Per-thread cache of free objects */
+typedef struct {
+    volatile int busy;  /* set while a thread is using the magazine */
+    int count;
+    void *objs[MAG_SIZE];
+} magazine_t;
+#endif
+
+struct mm_pool {
+    size_t obj_size;    /* object stride: a multiple of the alignment */
+    size_t align;       /* object alignment */
+    size_t chunk_size;  /* bytes requested from mm for each chunk */
+    void *free_list;    /* LIFO list of freed objects */
+    void *chunks;       /* chunks, linked through their first word */
+    char *bump;         /* next uncarved object in the newest chunk */
+    char *limit;        /* end of the newest chunk */
+#ifdef MM_THREADS
+    pthread_mutex_t lock;
+    magazine_t mags[MAG_THREADS];
+#endif
+};
+
+#ifdef MM_THREADS
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER; /* mm calls */
+static int next_slot = 0;                /* next thread slot to hand out */
+static __thread int thread_slot = -1;    /* this thread's slot */
+#endif
+
+static void *shared_alloc(mm_pool_t *);
+static void shared_free(mm_pool_t *, void *);
+
+/*
+ * mm_pool_create - create a pool of obj_size-byte objects aligned to
+ *     align bytes (a power of 2; 0 means the mm alignment). Returns
+ *     NULL on bad arguments or if the pool record can't be allocated.
+ */
+mm_pool_t *mm_pool_create(size_t obj_size, size_t align)
+{
+    mm_pool_t *pool;
+    size_t pagesize = mem_pagesize();
+
+    if (align == 0)
+	align = sizeof(void *);
+    if (obj_size == 0 || (align & (align - 1)) != 0)
+	return NULL;
+    align = MAX(align, sizeof(void *));
+
+#ifdef MM_THREADS
+    pthread_mutex_lock(&heap_lock);
+    pool = mm_malloc(sizeof(mm_pool_t));
+    pthread_mutex_unlock(&heap_lock);
+#else
+    pool = mm_malloc(sizeof(mm_pool_t));
+#endif
+    if (pool == NULL)
+	return NULL;
+    pool->obj_size = ALIGN_UP(MAX(obj_size, sizeof(void *)), align);
+    pool->align = align;
+
+    /* One page per chunk (mm overhead included), unless that's too small */
+    pool->chunk_size = MAX(pagesize - BLOCK_OVERHEAD, 
+			   sizeof(void *) + (align - 1) + 
+			   POOL_MINOBJS * pool->obj_size);
+    pool->free_list = NULL;
+    pool->chunks = NULL;
+    pool->bump = NULL;
+    pool->limit = NULL;
+#ifdef MM_THREADS
+    pthread_mutex_init(&pool->lock, NULL);
+    memset(pool->mags, 0, sizeof(pool->mags));
+#endif
+    return pool;
+}
+
+/*
+ * shared_alloc - take an object from the shared free list, or carve
+ *     one from the newest chunk, getting a new chunk if needed.
+ *     Called with the pool lock held in the threaded build.
+ */
+static void *shared_alloc(mm_pool_t *pool)
+{
+    void *obj;
+    char *chunk;
+
+    if ((obj = pool->free_list) != NULL) {
+	pool->free_list = NEXT_OBJ(obj);
+	return obj;
+    }
+
+    if (pool->bump == NULL || 
+	pool->obj_size > (size_t)(pool->limit - pool->bump)) {
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+	chunk = mm_malloc(pool->chunk_size);
+	pthread_mutex_unlock(&heap_lock);
+#else
+	chunk = mm_malloc(pool->chunk_size);
+#endif
+	if (chunk == NULL)
+	    return NULL;
+	NEXT_OBJ(chunk) = pool->chunks;
+	pool->chunks = chunk;
+	pool->bump = (char *)ALIGN_UP((size_t)(chunk + sizeof(void *)), 
+				      pool->align);
+	pool->limit = chunk + pool->chunk_size;
+    }
+
+    obj = pool->bump;
+    pool->bump += pool->obj_size;
+    return obj;
+}
+
+/*
+ * shared_free - push an object on the shared free list.
+ *     Called with the pool lock held in the threaded build.
+ */
+static void shared_free(mm_pool_t *pool, void *ptr)
+{
+    NEXT_OBJ(ptr) = pool->free_list;
+    pool->free_list = ptr;
+}
+
+#ifdef MM_THREADS
+/*
+ * get_magazine - claim this thread's magazine in pool, or return
+ *     NULL if a thread sharing the slot is using it right now.
+ */
+static magazine_t *get_magazine(mm_pool_t *pool)
+{
+    magazine_t *mag;
+
+    if (thread_slot < 0)
+	thread_slot = __sync_fetch_and_add(&next_slot, 1) % MAG_THREADS;
+
+    mag = &pool->mags[thread_slot];
+    if (__sync_lock_test_and_set(&mag->busy, 1))
+	return NULL;
+    return mag;
+}
+
+static void put_magazine(magazine_t *mag)
+{
+    __sync_lock_release(&mag->busy);
+}
+#endif
+
+/*
+ * mm_pool_alloc - allocate one object from the pool
+ */
+void *mm_pool_alloc(mm_pool_t *pool)
+{
+#ifdef MM_THREADS
+    magazine_t *mag = get_magazine(pool);
+    void *obj = NULL;
+
+    if (mag != NULL && mag->count > 0) {
+	obj = mag->objs[--mag->count];
+	put_magazine(mag);
+	return obj;
+    }
+
+    /* Refill half a magazine from the shared pool */
+    pthread_mutex_lock(&pool->lock);
+    if (mag != NULL) {
+	while (mag->count < MAG_SIZE / 2 && 
+	       (obj = shared_alloc(pool)) != NULL)
+	    mag->objs[mag->count++] = obj;
+	obj = (mag->count > 0) ? mag->objs[--mag->count] : NULL;
+    } 
+    else
+	obj = shared_alloc(pool);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (mag != NULL)
+	put_magazine(mag);
+    return obj;
+#else
+    return shared_alloc(pool);
+#endif
+}
+
+/*
+ * mm_pool_free - return an object to the pool it came from
+ */
+void mm_pool_free(mm_pool_t *pool, void *ptr)
+{
+#ifdef MM_THREADS
+    magazine_t *mag = get_magazine(pool);
+
+    if (mag != NULL && mag->count < MAG_SIZE) {
+	mag->objs[mag->count++] = ptr;
+	put_magazine(mag);
+	return;
+    }
+
+    /* Give half a magazine back to the shared pool */
+    pthread_mutex_lock(&pool->lock);
+    if (mag != NULL) {
+	while (mag->count > MAG_SIZE / 2)
+	    shared_free(pool, mag->objs[--mag->count]);
+	mag->objs[mag->count++] = ptr;
+    } 
+    else
+	shared_free(pool, ptr);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (mag != NULL)
+	put_magazine(mag);
+#else
+    shared_free(pool, ptr);
+#endif
+}
+
+/*
+ * mm_pool_destroy - return all of the pool's chunks to the heap. 
+ *     Every object from the pool is freed with them.
+ */
+void mm_pool_destroy(mm_pool_t *pool)
+{
+    void *chunk, *next;
+
+#ifdef MM_THREADS
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_lock(&heap_lock);
+#endif
+    for (chunk = pool->chunks; chunk != NULL; chunk = next) {
+	next = NEXT_OBJ(chunk);
+	mm_free(chunk);
+    }
+    mm_free(pool);
+#ifdef MM_THREADS
+    pthread_mutex_unlock(&heap_lock);
+#endif
+}
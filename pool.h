@@ -0,0 +1,15 @@
+/*
+ * pool.h - fixed-size object pools
+ *
+ * A pool hands out objects of one size from page-sized chunks of the
+ * mm heap, with no per-object header. Freed objects go on a LIFO free
+ * list threaded through the objects themselves.
+ */
+#include <stddef.h>
+
+typedef struct mm_pool mm_pool_t;
+
+extern mm_pool_t *mm_pool_create(size_t obj_size, size_t align);
+extern void *mm_pool_alloc(mm_pool_t *pool);
+extern void mm_pool_free(mm_pool_t *pool, void *ptr);
+extern void mm_pool_destroy(mm_pool_t *pool);
@@ -0,0 +1,160 @@
+/*
+ * poolbench.c - compare fixed-size pool alloc/free latency with
+ *     mm_malloc/mm_free for the same object size.
+ *
+ * Each round allocates a batch of objects and frees them again, in
+ * LIFO order or in an interleaved order that mixes the free list up.
+ * Times are per alloc+free pair, measured with the fsecs package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "pool.h"
+#include "fsecs.h"
+
+#define DEF_SIZE   32     /* default object size */
+#define DEF_BATCH  1000   /* default objects per round */
+#define DEF_ROUNDS 100    /* default rounds per measurement */
+
+int verbose = 0;  /* required by fsecs.c */
+
+/* Parameters for the timed functions */
+typedef struct {
+    size_t size;       /* object size */
+    int batch;         /* objects per round */
+    int rounds;        /* rounds per call */
+    int interleave;    /* free even objects first, then odd ones */
+    mm_pool_t *pool;
+    void **objs;
+} bench_t;
+
+/*
+ * bench_mm - alloc and free through mm_malloc/mm_free
+ */
+static void bench_mm(void *argp)
+{
+    bench_t *b = (bench_t *)argp;
+    int r, i;
+
+    for (r = 0; r < b->rounds; r++) {
+	for (i = 0; i < b->batch; i++)
+	    b->objs[i] = mm_malloc(b->size);
+	if (b->interleave) {
+	    for (i = 0; i < b->batch; i += 2)
+		mm_free(b->objs[i]);
+	    for (i = 1; i < b->batch; i += 2)
+		mm_free(b->objs[i]);
+	} 
+	else {
+	    for (i = b->batch - 1; i >= 0; i--)
+		mm_free(b->objs[i]);
+	}
+    }
+}
+
+/*
+ * bench_pool - alloc and free through mm_pool_alloc/mm_pool_free
+ */
+static void bench_pool(void *argp)
+{
+    bench_t *b = (bench_t *)argp;
+    int r, i;
+
+    for (r = 0; r < b->rounds; r++) {
+	for (i = 0; i < b->batch; i++)
+	    b->objs[i] = mm_pool_alloc(b->pool);
+	if (b->interleave) {
+	    for (i = 0; i < b->batch; i += 2)
+		mm_pool_free(b->pool, b->objs[i]);
+	    for (i = 1; i < b->batch; i += 2)
+		mm_pool_free(b->pool, b->objs[i]);
+	} 
+	else {
+	    for (i = b->batch - 1; i >= 0; i--)
+		mm_pool_free(b->pool, b->objs[i]);
+	}
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: poolbench [-h] [-s <size>] [-n <batch>] [-r <rounds>]\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h          Print this message.\n");
+    fprintf(stderr, "\t-s <size>   Object size in bytes (default %d).\n", DEF_SIZE);
+    fprintf(stderr, "\t-n <batch>  Objects allocated per round (default %d).\n", DEF_BATCH);
+    fprintf(stderr, "\t-r <rounds> Rounds per measurement (default %d).\n", DEF_ROUNDS);
+}
+
+int main(int argc, char **argv)
+{
+    bench_t b;
+    char c;
+    double mm_secs, pool_secs, pairs;
+
+    b.size = DEF_SIZE;
+    b.batch = DEF_BATCH;
+    b.rounds = DEF_ROUNDS;
+
+    while ((c = getopt(argc, argv, "hs:n:r:")) != EOF) {
+	switch (c) {
+	case 's':
+	    b.size = atoi(optarg);
+	    break;
+	case 'n':
+	    b.batch = atoi(optarg);
+	    break;
+	case 'r':
+	    b.rounds = atoi(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (b.size == 0 || b.batch <= 0 || b.rounds <= 0) {
+	usage();
+	exit(1);
+    }
+
+    if ((b.objs = malloc(b.batch * sizeof(void *))) == NULL) {
+	fprintf(stderr, "poolbench: malloc failed\n");
+	exit(1);
+    }
+
+    mem_init();
+    if (mm_init() < 0) {
+	fprintf(stderr, "poolbench: mm_init failed\n");
+	exit(1);
+    }
+    if ((b.pool = mm_pool_create(b.size, 0)) == NULL) {
+	fprintf(stderr, "poolbench: mm_pool_create failed\n");
+	exit(1);
+    }
+    init_fsecs();
+
+    pairs = (double)b.batch * b.rounds;
+    printf("%d x %lu-byte objects, %d rounds\n", 
+	   b.batch, (unsigned long)b.size, b.rounds);
+    printf("%-12s%14s%14s%10s\n", "order", "mm ns/pair", "pool ns/pair", "speedup");
+    for (b.interleave = 0; b.interleave <= 1; b.interleave++) {
+	mm_secs = fsecs(bench_mm, &b);
+	pool_secs = fsecs(bench_pool, &b);
+	printf("%-12s%14.1f%14.1f%9.1fx\n", 
+	       b.interleave ? "interleaved" : "lifo",
+	       mm_secs * 1e9 / pairs, 
+	       pool_secs * 1e9 / pairs,
+	       mm_secs / pool_secs);
+    }
+
+    mm_pool_destroy(b.pool);
+    mem_deinit();
+    exit(0);
+}
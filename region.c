@@ -0,0 +1,207 @@
+/*
+ * region.c - bump-pointer regions (arenas) with bulk release
+ *
+ * A region hands out memory by bumping a pointer through a chain of
+ * chunks. There is no per-object header and no per-object free: the
+ * whole region is released at once by mm_region_reset() or
+ * mm_region_destroy().
+ *
+ * Chunks come from one of two sources:
+ *   - an mm heap (mm_heap_malloc), so regions share the main heap with
+ *     ordinary allocations. Reset returns all chunks but the newest one.
+ *   - a private memlib heap (heap == NULL). Chunks are carved straight
+ *     from its brk, so reset is a brk reset and destroy is one unmap.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "region.h"
+#include "memlib.h"
+#include "config.h"
+
+/* rounds up to the nearest multiple of ALIGNMENT */
+#define ALIGN(size) (((size) + (ALIGNMENT-1)) & ~(ALIGNMENT-1))
+
+#define REGION_CHUNKSIZE (1<<12)  /* Default chunk size (bytes) */
+
+/* Every chunk starts with this header */
+typedef struct chunk {
+    struct chunk *next;  /* next older chunk in the chain */
+    size_t size;         /* size of the chunk, header included */
+} chunk_t;
+
+#define CHUNK_HDRSIZE ALIGN(sizeof(chunk_t))
+
+struct mm_region {
+    mm_heap_t *heap;  /* chunk source, or NULL... */
+    mem_t *mem;       /* ...for the private memlib heap */
+    chunk_t *chunks;  /* newest chunk, head of the chain */
+    char *cur;        /* next free byte in the newest chunk */
+    char *limit;      /* end of the newest chunk */
+};
+
+#define REGION_HDRSIZE ALIGN(sizeof(mm_region_t))
+
+static chunk_t *new_chunk(mm_region_t *, size_t);
+
+/*
+ * mm_region_create - create an empty region. Returns NULL if the
+ *     region record can't be allocated.
+ */
+mm_region_t *mm_region_create(mm_heap_t *heap)
+{
+    mm_region_t *region;
+    mem_t *mem = NULL;
+
+    if (heap != NULL) {
+	if ((region = mm_heap_malloc(heap, sizeof(mm_region_t))) == NULL)
+	    return NULL;
+    } 
+    else {
+	if ((mem = mem_create(MAX_HEAP)) == NULL)
+	    return NULL;
+	if ((long)(region = mem_sbrk_r(mem, REGION_HDRSIZE)) == -1) {
+	    mem_destroy(mem);
+	    return NULL;
+	}
+    }
+
+    region->heap = heap;
+    region->mem = mem;
+    region->chunks = NULL;
+    region->cur = NULL;
+    region->limit = NULL;
+    return region;
+}
+
+/*
+ * new_chunk - get a chunk with room for at least size bytes and make
+ *     it the head of the chain.
+ */
+static chunk_t *new_chunk(mm_region_t *region, size_t size)
+{
+    chunk_t *chunk;
+    size_t csize = CHUNK_HDRSIZE + size;
+
+    if (csize < REGION_CHUNKSIZE)
+	csize = REGION_CHUNKSIZE;
+
+    if (region->heap != NULL) {
+	/* Leave room for the mm block header and footer */
+	if (csize == REGION_CHUNKSIZE)
+	    csize -= 2 * sizeof(int);
+	if ((chunk = mm_heap_malloc(region->heap, csize)) == NULL)
+	    return NULL;
+    } 
+    else {
+	if ((long)(chunk = mem_sbrk_r(region->mem, csize)) == -1)
+	    return NULL;
+    }
+
+    chunk->next = region->chunks;
+    chunk->size = csize;
+    region->chunks = chunk;
+    region->cur = (char *)chunk + CHUNK_HDRSIZE;
+    region->limit = (char *)chunk + csize;
+    return chunk;
+}
+
+/*
+ * mm_region_alloc - bump-allocate size bytes from the region. Sizes
+ *     larger than a whole heap are refused before they can wrap in
+ *     ALIGN or overflow the int that mem_sbrk_r takes.
+ */
+void *mm_region_alloc(mm_region_t *region, size_t size)
+{
+    char *p;
+
+    if (size == 0 || size > MAX_HEAP)
+	return NULL;
+    size = ALIGN(size);
+
+    if (region->cur == NULL || size > (size_t)(region->limit - region->cur)) {
+	if (new_chunk(region, size) == NULL)
+	    return NULL;
+    }
+
+    p = region->cur;
+    region->cur += size;
+    return p;
+}
+
+/*
+ * mm_region_realloc - grow or shrink an object from this region. The
+ *     most recent object is resized in place when the chunk has room;
+ *     otherwise a new object is bump-allocated and the data copied.
+ *     The old space is reclaimed only when the region is reset.
+ */
+void *mm_region_realloc(mm_region_t *region, void *ptr, 
+			size_t oldsize, size_t size)
+{
+    char *newp;
+
+    if (ptr == NULL)
+	return mm_region_alloc(region, size);
+    if (size == 0 || size > MAX_HEAP)
+	return NULL;
+
+    /* Last object allocated: just move the bump pointer */
+    if ((char *)ptr + ALIGN(oldsize) == region->cur &&
+	ALIGN(size) <= (size_t)(region->limit - (char *)ptr)) {
+	region->cur = (char *)ptr + ALIGN(size);
+	return ptr;
+    }
+
+    if ((newp = mm_region_alloc(region, size)) == NULL)
+	return NULL;
+    memcpy(newp, ptr, (oldsize < size) ? oldsize : size);
+    return newp;
+}
+
+/*
+ * mm_region_reset - release every object in the region. With a
+ *     private memlib heap this is a brk reset; with an mm heap every
+ *     chunk but the newest is returned to the heap and the newest one
+ *     is kept for reuse.
+ */
+void mm_region_reset(mm_region_t *region)
+{
+    chunk_t *chunk, *next;
+
+    if (region->heap == NULL) {
+	mem_reset_brk_r(region->mem);
+	mem_sbrk_r(region->mem, REGION_HDRSIZE);  /* keep the region record */
+	region->chunks = NULL;
+	region->cur = NULL;
+	region->limit = NULL;
+	return;
+    }
+
+    if ((chunk = region->chunks) == NULL)
+	return;
+    for (next = chunk->next; next != NULL; next = chunk->next) {
+	chunk->next = next->next;
+	mm_heap_free(region->heap, next);
+    }
+    region->cur = (char *)chunk + CHUNK_HDRSIZE;
+}
+
+/*
+ * mm_region_destroy - release the region and everything allocated from it
+ */
+void mm_region_destroy(mm_region_t *region)
+{
+    chunk_t *chunk, *next;
+
+    if (region->heap == NULL) {
+	mem_destroy(region->mem);
+	return;
+    }
+
+    for (chunk = region->chunks; chunk != NULL; chunk = next) {
+	next = chunk->next;
+	mm_heap_free(region->heap, chunk);
+    }
+    mm_heap_free(region->heap, region);
+}
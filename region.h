@@ -0,0 +1,19 @@
+/*
+ * region.h - bump-pointer regions (arenas) with bulk release
+ *
+ * Objects allocated from a region are never freed one at a time;
+ * mm_region_reset() releases all of them at once.
+ */
+#include <stddef.h>
+
+#include "mm.h"
+
+typedef struct mm_region mm_region_t;
+
+/* Chunks come from heap, or from a private memlib heap if heap is NULL */
+extern mm_region_t *mm_region_create(mm_heap_t *heap);
+extern void *mm_region_alloc(mm_region_t *region, size_t size);
+extern void *mm_region_realloc(mm_region_t *region, void *ptr,
+			       size_t oldsize, size_t size);
+extern void mm_region_reset(mm_region_t *region);
+extern void mm_region_destroy(mm_region_t *region);
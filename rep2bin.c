@@ -0,0 +1,61 @@
+/*
+ * rep2bin.c - convert a trace to the binary trace format that mdriver
+ *     maps without parsing, or with -z to the compressed format that
+ *     "mdriver -S" streams:
+ *
+ *         unix> rep2bin traces/cccp-bal.rep cccp-bal.bin
+ *         unix> mdriver -f cccp-bal.bin
+ *
+ *     The input may be in any of the three forms. The output is in
+ *     native byte order; see trace.h.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: rep2bin [-hz] <in> <out>\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h  Print this message.\n");
+    fprintf(stderr, "\t-z  Write the compressed format.\n");
+}
+
+int main(int argc, char **argv)
+{
+    tracefile_t tf;
+    int compress = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "hz")) != EOF) {
+	switch (c) {
+	case 'z':
+	    compress = 1;
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (argc - optind != 2) {
+	usage();
+	exit(1);
+    }
+
+    if (trace_load(argv[optind], &tf) < 0)
+	exit(1);
+    if (compress) {
+	if (trace_save_lz(argv[optind + 1], &tf) < 0)
+	    exit(1);
+    } else if (trace_save_bin(argv[optind + 1], &tf) < 0)
+	exit(1);
+    printf("%s: %d requests, %d ids\n", argv[optind + 1], tf.hdr.num_ops,
+	   tf.hdr.num_ids);
+    trace_unload(&tf);
+    exit(0);
+}
@@ -0,0 +1,94 @@
+/*
+ * runstats.c - summaries of repeated measurements; see runstats.h
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "runstats.h"
+
+#define T_TABLE 30   /* degrees of freedom with exact quantiles below */
+
+/* Two-sided 95% and 99% quantiles of Student's t, by degrees of freedom */
+static const double t95[T_TABLE + 1] = {0,
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+static const double t99[T_TABLE + 1] = {0,
+    63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169,
+    3.106, 3.055, 3.012, 2.977, 2.947, 2.921, 2.898, 2.878, 2.861, 2.845,
+    2.831, 2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750
+};
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * t_crit - the two-sided level% (95 or 99) critical value of Student's
+ *     t with df degrees of freedom; above T_TABLE, the normal quantile
+ *     with the first term of the Cornish-Fisher correction
+ */
+double t_crit(double df, int level)
+{
+    double z = (level == 99) ? 2.5758 : 1.9600;
+    int d = (int)df;
+
+    if (d < 1)
+	d = 1;
+    if (d <= T_TABLE)
+	return (level == 99) ? t99[d] : t95[d];
+    return z + (z * z * z + z) / (4 * df);
+}
+
+/*
+ * runstats - summarize the n measurements in x
+ */
+void runstats(const double *x, int n, runstats_t *rs)
+{
+    double *s, sum = 0, sq = 0;
+    int i;
+
+    memset(rs, 0, sizeof(*rs));
+    if ((rs->n = n) == 0 || (s = malloc(n * sizeof(double))) == NULL)
+	return;
+    memcpy(s, x, n * sizeof(double));
+    qsort(s, n, sizeof(double), cmp_double);
+    for (i = 0; i < n; i++)
+	sum += s[i];
+    rs->mean = sum / n;
+    rs->median = (n % 2) ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+    for (i = 0; i < n; i++)
+	sq += (s[i] - rs->mean) * (s[i] - rs->mean);
+    if (n > 1) {
+	rs->sd = sqrt(sq / (n - 1));
+	rs->ci = t_crit(n - 1, 95) * rs->sd / sqrt(n);
+    }
+    free(s);
+}
+
+/*
+ * welch - Welch's t-test of the means of a and b: 2 if they differ at
+ *     the 1% level, 1 if at the 5% level, 0 if not (or can't tell)
+ */
+int welch(const runstats_t *a, const runstats_t *b)
+{
+    double va, vb, se, t, df;
+
+    if (a->n < 2 || b->n < 2)
+	return 0;
+    va = a->sd * a->sd / a->n;
+    vb = b->sd * b->sd / b->n;
+    if ((se = sqrt(va + vb)) == 0)
+	return a->mean != b->mean ? 2 : 0;
+    t = fabs(a->mean - b->mean) / se;
+    df = (va + vb) * (va + vb) /
+	(va * va / (a->n - 1) + vb * vb / (b->n - 1));
+    if (t > t_crit(df, 99))
+	return 2;
+    return t > t_crit(df, 95);
+}
@@ -0,0 +1,20 @@
+/*
+ * runstats.h - summaries of repeated measurements, for mdriver -r and
+ *     mdcompare
+ */
+#ifndef __RUNSTATS_H_
+#define __RUNSTATS_H_
+
+typedef struct {
+    int n;           /* measurements */
+    double mean;
+    double median;
+    double sd;       /* sample standard deviation */
+    double ci;       /* half width of the 95% confidence interval of mean */
+} runstats_t;
+
+void runstats(const double *x, int n, runstats_t *rs);
+double t_crit(double df, int level);
+int welch(const runstats_t *a, const runstats_t *b);
+
+#endif /* __RUNSTATS_H_ */
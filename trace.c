@@ -0,0 +1,694 @@
+/*
+ * trace.c - load and save malloc lab traces
+ *
+ * Text and compressed traces are decoded into a malloc'd array of
+ * requests. Binary traces are mapped read-only, and the requests are
+ * used where they lie in the mapping, so loading one costs a header
+ * check and one pass over the requests to validate them, but no copy.
+ *
+ * A streamed trace has a prefetch thread and two windows. The thread
+ * decodes into one window while the reader replays the other, and
+ * they trade windows under a mutex. Rewinding stops the thread and
+ * starts a new one at the first block.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+#include "lz.h"
+
+#define MAXLINE 1024  /* max string size */
+#define WINDOW_BYTES (TRACE_WINDOW * sizeof(traceop_t))
+
+/* Reads the requests of a binary or compressed trace in windows */
+typedef struct {
+    FILE *fp;
+    const char *path;
+    int lz;              /* compressed? */
+    int left;            /* requests not read yet */
+    int num_ids;         /* bound on the request ids */
+    char *zbuf;          /* one compressed block */
+} reader_t;
+
+/* Window states */
+enum {WIN_EMPTY, WIN_FULL, WIN_END, WIN_ERROR};
+
+struct tracestream {
+    reader_t rd;
+    char path[MAXLINE];
+    long data_off;       /* file offset of the first request */
+    int num_ops;
+    pthread_t thread;
+    int running;         /* thread started and not joined */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stop;            /* tells the thread to quit */
+    traceop_t *win[2];
+    int len[2];
+    int state[2];
+    int cur;             /* window the reader holds, or -1 */
+    int next;            /* window the reader takes next */
+    double stall;        /* seconds the reader waited */
+};
+
+/*
+ * read_rep - parse the text trace in fp into tf
+ */
+static int read_rep(FILE *fp, const char *path, tracefile_t *tf)
+{
+    tracehdr_t *hdr = &tf->hdr;
+    traceop_t *op;
+    char type[MAXLINE];
+    unsigned index, size, count, align;
+    unsigned max_index = 0;
+    int op_index;
+
+    if (fscanf(fp, "%d %d %d %d", &hdr->sugg_heapsize, &hdr->num_ids,
+	       &hdr->num_ops, &hdr->weight) != 4 ||
+	hdr->num_ids < 0 || hdr->num_ops < 0) {
+	fprintf(stderr, "Bad header in tracefile %s\n", path);
+	return -1;
+    }
+
+    /* We'll store each request line in the trace in this array */
+    if ((tf->ops = malloc((hdr->num_ops + 1) * sizeof(traceop_t))) == NULL) {
+	fprintf(stderr, "Out of memory reading tracefile %s\n", path);
+	return -1;
+    }
+
+    /* read every request line in the trace file */
+    hdr->num_reqs = 0;
+    for (op_index = 0; fscanf(fp, "%s", type) != EOF; op_index++) {
+	if (op_index == hdr->num_ops) {
+	    fprintf(stderr, "More than %d requests in tracefile %s\n",
+		    hdr->num_ops, path);
+	    return -1;
+	}
+	op = &tf->ops[op_index];
+	index = size = count = align = 0;
+	switch(type[0]) {
+	case 'a':
+	    fscanf(fp, "%u %u", &index, &size);
+	    op->type = ALLOC;
+	    op->align = 0;
+	    break;
+	case 'm':
+	    fscanf(fp, "%u %u %u", &index, &align, &size);
+	    if (align == 0 || (align & (align - 1)) != 0) {
+		fprintf(stderr, "Bad alignment (%u) in tracefile %s\n",
+			align, path);
+		return -1;
+	    }
+	    op->type = ALLOC;
+	    op->align = align;
+	    break;
+	case 'c':
+	    fscanf(fp, "%u %u %u", &index, &count, &size);
+	    if (count == 0) {
+		fprintf(stderr, "Bad calloc of 0 elements in tracefile %s\n",
+			path);
+		return -1;
+	    }
+	    op->type = CALLOC;
+	    op->nmemb = count;
+	    size *= count;
+	    break;
+	case 'r':
+	    fscanf(fp, "%u %u", &index, &size);
+	    op->type = REALLOC;
+	    op->align = 0;
+	    break;
+	case 'f':
+	    fscanf(fp, "%u", &index);
+	    op->type = FREE;
+	    op->align = 0;
+	    break;
+	case 'x':
+	    op->type = RELEASE;
+	    op->align = 0;
+	    break;
+	case 'A':
+	    fscanf(fp, "%u %u %u", &index, &size, &count);
+	    op->type = ALLOC_BATCH;
+	    op->count = count;
+	    break;
+	case 'F':
+	    fscanf(fp, "%u %u", &index, &count);
+	    op->type = FREE_BATCH;
+	    op->count = count;
+	    break;
+	default:
+	    fprintf(stderr, "Bogus type character (%c) in tracefile %s\n",
+		    type[0], path);
+	    return -1;
+	}
+	op->index = index;
+	op->size = size;
+
+	if (op->type == ALLOC_BATCH || op->type == FREE_BATCH) {
+	    hdr->num_reqs += count;
+	    index += count - 1;
+	} else
+	    hdr->num_reqs++;
+	if (op->type != FREE && op->type != FREE_BATCH &&
+	    op->type != RELEASE && index > max_index)
+	    max_index = index;
+    }
+
+    if (op_index != hdr->num_ops) {
+	fprintf(stderr, "Expected %d requests, found %d in tracefile %s\n",
+		hdr->num_ops, op_index, path);
+	return -1;
+    }
+    if (op_index > 0 && max_index != hdr->num_ids - 1) {
+	fprintf(stderr, "Expected %d ids, found %u in tracefile %s\n",
+		hdr->num_ids, max_index + 1, path);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * check_ops - validate n binary requests, so that a bad file can't send
+ *     the driver outside its block arrays
+ */
+static int check_ops(const traceop_t *ops, int n, int num_ids,
+		     const char *path)
+{
+    const traceop_t *op;
+    int i, bad;
+
+    for (i = 0; i < n; i++) {
+	op = &ops[i];
+	bad = 0;
+	switch (op->type) {
+	case RELEASE:
+	    break;
+	case ALLOC_BATCH:
+	case FREE_BATCH:
+	    bad = op->count <= 0 || op->index < 0 ||
+		op->index > num_ids - op->count;
+	    break;
+	case ALLOC:
+	    bad = op->align < 0 || (op->align & (op->align - 1)) != 0;
+	    /* fall through */
+	case REALLOC:
+	case CALLOC:
+	case FREE:
+	    bad = bad || op->index < 0 || op->index >= num_ids ||
+		op->size < 0 || (op->type == CALLOC && op->nmemb <= 0);
+	    break;
+	default:
+	    fprintf(stderr, "Bogus request type (%d) in tracefile %s\n",
+		    op->type, path);
+	    return -1;
+	}
+	if (bad) {
+	    fprintf(stderr, "Bad request %d (type %d, id %d) in tracefile %s\n",
+		    i, op->type, op->index, path);
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/*
+ * read_window - read the next window of requests into ops. Returns the
+ *     number read, 0 at the end of the trace, or -1.
+ */
+static int read_window(reader_t *rd, traceop_t *ops)
+{
+    traceblk_t blk;
+    long len;
+    int i, prev;
+
+    if (rd->left == 0)
+	return 0;
+    if (!rd->lz) {
+	blk.num_ops = (rd->left < TRACE_WINDOW) ? rd->left : TRACE_WINDOW;
+	if (fread(ops, sizeof(traceop_t), blk.num_ops, rd->fp) != blk.num_ops)
+	    goto truncated;
+	if (check_ops(ops, blk.num_ops, rd->num_ids, rd->path) < 0)
+	    return -1;
+	rd->left -= blk.num_ops;
+	return blk.num_ops;
+    }
+
+    if (fread(&blk, sizeof(blk), 1, rd->fp) != 1)
+	goto truncated;
+    if (blk.num_ops <= 0 || blk.num_ops > TRACE_WINDOW ||
+	blk.num_ops > rd->left || blk.comp_len < 0 ||
+	blk.comp_len > LZ_BOUND(WINDOW_BYTES)) {
+	fprintf(stderr, "Bad block in tracefile %s\n", rd->path);
+	return -1;
+    }
+    if (fread(rd->zbuf, 1, blk.comp_len, rd->fp) != blk.comp_len)
+	goto truncated;
+    len = lz_decompress(rd->zbuf, blk.comp_len, ops, WINDOW_BYTES);
+    if (len != blk.num_ops * sizeof(traceop_t)) {
+	fprintf(stderr, "Corrupt block in tracefile %s\n", rd->path);
+	return -1;
+    }
+    for (i = 0, prev = 0; i < blk.num_ops; i++)
+	prev = ops[i].index += prev;
+    if (check_ops(ops, blk.num_ops, rd->num_ids, rd->path) < 0)
+	return -1;
+    rd->left -= blk.num_ops;
+    return blk.num_ops;
+
+ truncated:
+    fprintf(stderr, "Truncated tracefile %s\n", rd->path);
+    return -1;
+}
+
+/*
+ * read_lz - decode the compressed trace in fp, past its magic, into tf
+ */
+static int read_lz(FILE *fp, const char *path, tracefile_t *tf)
+{
+    reader_t rd;
+    int n, done = 0;
+
+    rewind(fp);
+    if (fread(&tf->hdr, sizeof(tf->hdr), 1, fp) != 1 ||
+	tf->hdr.op_size != sizeof(traceop_t) || tf->hdr.num_ops < 0 ||
+	tf->hdr.num_ids < 0) {
+	fprintf(stderr, "Bad header in tracefile %s\n", path);
+	return -1;
+    }
+    rd.fp = fp;
+    rd.path = path;
+    rd.lz = 1;
+    rd.left = tf->hdr.num_ops;
+    rd.num_ids = tf->hdr.num_ids;
+    if ((tf->ops = malloc((tf->hdr.num_ops + 1) * sizeof(traceop_t))) == NULL ||
+	(rd.zbuf = malloc(LZ_BOUND(WINDOW_BYTES))) == NULL) {
+	fprintf(stderr, "Out of memory reading tracefile %s\n", path);
+	return -1;
+    }
+    while ((n = read_window(&rd, tf->ops + done)) > 0)
+	done += n;
+    free(rd.zbuf);
+    return (n < 0) ? -1 : 0;
+}
+
+/*
+ * map_bin - map the binary trace open on fd into tf
+ */
+static int map_bin(int fd, const char *path, tracefile_t *tf)
+{
+    struct stat st;
+    tracehdr_t *hdr;
+
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(tracehdr_t)) {
+	fprintf(stderr, "Truncated binary tracefile %s\n", path);
+	return -1;
+    }
+    tf->map_len = st.st_size;
+    tf->map = mmap(NULL, tf->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (tf->map == MAP_FAILED) {
+	tf->map = NULL;
+	fprintf(stderr, "Could not map tracefile %s\n", path);
+	return -1;
+    }
+    madvise(tf->map, tf->map_len, MADV_WILLNEED);
+
+    hdr = (tracehdr_t *)tf->map;
+    if (hdr->op_size != sizeof(traceop_t) || hdr->num_ops < 0 ||
+	hdr->num_ids < 0 || tf->map_len != sizeof(tracehdr_t) +
+	(size_t)hdr->num_ops * sizeof(traceop_t)) {
+	fprintf(stderr, "Bad header in binary tracefile %s\n", path);
+	return -1;
+    }
+    tf->hdr = *hdr;
+    tf->ops = (traceop_t *)(hdr + 1);
+    return check_ops(tf->ops, hdr->num_ops, hdr->num_ids, path);
+}
+
+/*
+ * trace_load - load the text or binary trace at path
+ */
+int trace_load(const char *path, tracefile_t *tf)
+{
+    char magic[sizeof(tf->hdr.magic)];
+    FILE *fp;
+    int rc, got;
+
+    memset(tf, 0, sizeof(*tf));
+    if ((fp = fopen(path, "r")) == NULL) {
+	fprintf(stderr, "Could not open tracefile %s\n", path);
+	return -1;
+    }
+    got = fread(magic, sizeof(magic), 1, fp);
+    if (got == 1 && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0)
+	rc = map_bin(fileno(fp), path, tf);
+    else if (got == 1 && memcmp(magic, TRACE_LZ_MAGIC, sizeof(magic)) == 0)
+	rc = read_lz(fp, path, tf);
+    else {
+	rewind(fp);
+	rc = read_rep(fp, path, tf);
+    }
+    fclose(fp);
+    if (rc < 0)
+	trace_unload(tf);
+    return rc;
+}
+
+/*
+ * trace_save_rep - write tf to path as a text trace
+ */
+int trace_save_rep(const char *path, const tracefile_t *tf)
+{
+    const tracehdr_t *hdr = &tf->hdr;
+    const traceop_t *op;
+    FILE *fp;
+    int i;
+
+    if ((fp = fopen(path, "w")) == NULL) {
+	fprintf(stderr, "Could not create tracefile %s\n", path);
+	return -1;
+    }
+    fprintf(fp, "%d\n%d\n%d\n%d\n", hdr->sugg_heapsize, hdr->num_ids,
+	    hdr->num_ops, hdr->weight);
+    for (i = 0; i < hdr->num_ops; i++) {
+	op = &tf->ops[i];
+	switch (op->type) {
+	case ALLOC:
+	    if (op->align == 0)
+		fprintf(fp, "a %d %d\n", op->index, op->size);
+	    else
+		fprintf(fp, "m %d %d %d\n", op->index, op->align, op->size);
+	    break;
+	case CALLOC:
+	    fprintf(fp, "c %d %d %d\n", op->index, op->nmemb,
+		    op->size / op->nmemb);
+	    break;
+	case REALLOC:
+	    fprintf(fp, "r %d %d\n", op->index, op->size);
+	    break;
+	case FREE:
+	    fprintf(fp, "f %d\n", op->index);
+	    break;
+	case RELEASE:
+	    fprintf(fp, "x\n");
+	    break;
+	case ALLOC_BATCH:
+	    fprintf(fp, "A %d %d %d\n", op->index, op->size, op->count);
+	    break;
+	case FREE_BATCH:
+	    fprintf(fp, "F %d %d\n", op->index, op->count);
+	    break;
+	}
+    }
+    if (fclose(fp) != 0) {
+	fprintf(stderr, "Could not write tracefile %s\n", path);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * trace_save_bin - write tf to path as a binary trace
+ */
+int trace_save_bin(const char *path, const tracefile_t *tf)
+{
+    tracehdr_t hdr = tf->hdr;
+    FILE *fp;
+    int ok;
+
+    memcpy(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.op_size = sizeof(traceop_t);
+    if ((fp = fopen(path, "w")) == NULL) {
+	fprintf(stderr, "Could not create tracefile %s\n", path);
+	return -1;
+    }
+    ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+	fwrite(tf->ops, sizeof(traceop_t), hdr.num_ops, fp) == hdr.num_ops;
+    if (fclose(fp) != 0 || !ok) {
+	fprintf(stderr, "Could not write tracefile %s\n", path);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * trace_save_lz - write tf to path as a compressed trace
+ */
+int trace_save_lz(const char *path, const tracefile_t *tf)
+{
+    tracehdr_t hdr = tf->hdr;
+    traceop_t *win;
+    traceblk_t blk;
+    char *zbuf;
+    FILE *fp;
+    int i, done, prev, ok;
+
+    memcpy(hdr.magic, TRACE_LZ_MAGIC, sizeof(hdr.magic));
+    hdr.op_size = sizeof(traceop_t);
+    if ((win = malloc(WINDOW_BYTES)) == NULL ||
+	(zbuf = malloc(LZ_BOUND(WINDOW_BYTES))) == NULL) {
+	fprintf(stderr, "Out of memory writing tracefile %s\n", path);
+	free(win);
+	return -1;
+    }
+    if ((fp = fopen(path, "w")) == NULL) {
+	fprintf(stderr, "Could not create tracefile %s\n", path);
+	free(win);
+	free(zbuf);
+	return -1;
+    }
+
+    ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    for (done = 0; ok && done < hdr.num_ops; done += blk.num_ops) {
+	blk.num_ops = hdr.num_ops - done;
+	if (blk.num_ops > TRACE_WINDOW)
+	    blk.num_ops = TRACE_WINDOW;
+	memcpy(win, tf->ops + done, blk.num_ops * sizeof(traceop_t));
+	for (i = 0, prev = 0; i < blk.num_ops; i++) {
+	    win[i].index -= prev;
+	    prev += win[i].index;
+	}
+	blk.comp_len = lz_compress(win, blk.num_ops * sizeof(traceop_t), zbuf);
+	ok = fwrite(&blk, sizeof(blk), 1, fp) == 1 &&
+	    fwrite(zbuf, 1, blk.comp_len, fp) == blk.comp_len;
+    }
+    free(win);
+    free(zbuf);
+    if (fclose(fp) != 0 || !ok) {
+	fprintf(stderr, "Could not write tracefile %s\n", path);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * trace_unload - release the requests of a loaded trace
+ */
+void trace_unload(tracefile_t *tf)
+{
+    if (tf->map != NULL)
+	munmap(tf->map, tf->map_len);
+    else
+	free(tf->ops);
+    tf->map = NULL;
+    tf->ops = NULL;
+}
+
+/*
+ * now - a monotonic clock, in seconds
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * prefetch - the prefetch thread: decode windows, alternating between
+ *     the two, as fast as the reader hands them back
+ */
+static void *prefetch(void *arg)
+{
+    tracestream_t *ts = arg;
+    int k = 0, n;
+
+    pthread_mutex_lock(&ts->lock);
+    for (;;) {
+	while (ts->state[k] != WIN_EMPTY && !ts->stop)
+	    pthread_cond_wait(&ts->cond, &ts->lock);
+	if (ts->stop)
+	    break;
+	pthread_mutex_unlock(&ts->lock);
+	n = read_window(&ts->rd, ts->win[k]);
+	pthread_mutex_lock(&ts->lock);
+	ts->len[k] = n;
+	ts->state[k] = (n > 0) ? WIN_FULL : (n == 0) ? WIN_END : WIN_ERROR;
+	pthread_cond_broadcast(&ts->cond);
+	if (n <= 0)
+	    break;
+	k ^= 1;
+    }
+    pthread_mutex_unlock(&ts->lock);
+    return NULL;
+}
+
+/*
+ * start - start the prefetch thread at the first request
+ */
+static int start(tracestream_t *ts)
+{
+    if (fseek(ts->rd.fp, ts->data_off, SEEK_SET) < 0) {
+	fprintf(stderr, "Could not rewind tracefile %s\n", ts->path);
+	return -1;
+    }
+    ts->rd.left = ts->num_ops;
+    ts->state[0] = ts->state[1] = WIN_EMPTY;
+    ts->cur = -1;
+    ts->next = 0;
+    ts->stop = 0;
+    if (pthread_create(&ts->thread, NULL, prefetch, ts) != 0) {
+	fprintf(stderr, "Could not start the prefetch thread\n");
+	return -1;
+    }
+    ts->running = 1;
+    return 0;
+}
+
+/*
+ * stop - stop the prefetch thread
+ */
+static void stop(tracestream_t *ts)
+{
+    if (!ts->running)
+	return;
+    pthread_mutex_lock(&ts->lock);
+    ts->stop = 1;
+    pthread_cond_broadcast(&ts->cond);
+    pthread_mutex_unlock(&ts->lock);
+    pthread_join(ts->thread, NULL);
+    ts->running = 0;
+}
+
+/*
+ * trace_stream_open - open the binary or compressed trace at path for
+ *     streaming, and start decoding it
+ */
+tracestream_t *trace_stream_open(const char *path, tracehdr_t *hdr)
+{
+    tracestream_t *ts;
+
+    if ((ts = calloc(1, sizeof(*ts))) == NULL) {
+	fprintf(stderr, "Out of memory opening tracefile %s\n", path);
+	return NULL;
+    }
+    pthread_mutex_init(&ts->lock, NULL);
+    pthread_cond_init(&ts->cond, NULL);
+    strncpy(ts->path, path, MAXLINE - 1);
+    ts->rd.path = ts->path;
+
+    if ((ts->win[0] = malloc(WINDOW_BYTES)) == NULL ||
+	(ts->win[1] = malloc(WINDOW_BYTES)) == NULL ||
+	(ts->rd.zbuf = malloc(LZ_BOUND(WINDOW_BYTES))) == NULL) {
+	fprintf(stderr, "Out of memory opening tracefile %s\n", path);
+	goto fail;
+    }
+
+    if ((ts->rd.fp = fopen(path, "r")) == NULL) {
+	fprintf(stderr, "Could not open tracefile %s\n", path);
+	goto fail;
+    }
+    if (fread(hdr, sizeof(*hdr), 1, ts->rd.fp) != 1 ||
+	(memcmp(hdr->magic, TRACE_MAGIC, sizeof(hdr->magic)) != 0 &&
+	 memcmp(hdr->magic, TRACE_LZ_MAGIC, sizeof(hdr->magic)) != 0)) {
+	fprintf(stderr, "%s is not a binary trace; convert it with "
+		"rep2bin to stream it\n", path);
+	goto fail;
+    }
+    if (hdr->op_size != sizeof(traceop_t) || hdr->num_ops < 0 ||
+	hdr->num_ids < 0) {
+	fprintf(stderr, "Bad header in tracefile %s\n", path);
+	goto fail;
+    }
+    ts->rd.lz = !memcmp(hdr->magic, TRACE_LZ_MAGIC, sizeof(hdr->magic));
+    ts->num_ops = hdr->num_ops;
+    ts->rd.num_ids = hdr->num_ids;
+    ts->data_off = sizeof(*hdr);
+    if (start(ts) < 0)
+	goto fail;
+    return ts;
+
+ fail:
+    trace_stream_close(ts);
+    return NULL;
+}
+
+/*
+ * trace_stream_next - hand the window the reader holds back to the
+ *     prefetch thread, and take the next one
+ */
+int trace_stream_next(tracestream_t *ts, traceop_t **ops)
+{
+    double t;
+    int k, n;
+
+    pthread_mutex_lock(&ts->lock);
+    if (ts->cur >= 0) {
+	ts->state[ts->cur] = WIN_EMPTY;
+	ts->cur = -1;
+	pthread_cond_broadcast(&ts->cond);
+    }
+    k = ts->next;
+    if (ts->state[k] == WIN_EMPTY) {
+	t = now();
+	while (ts->state[k] == WIN_EMPTY)
+	    pthread_cond_wait(&ts->cond, &ts->lock);
+	ts->stall += now() - t;
+    }
+    if (ts->state[k] == WIN_FULL) {
+	ts->cur = k;
+	ts->next = k ^ 1;
+	n = ts->len[k];
+	*ops = ts->win[k];
+    } else
+	n = (ts->state[k] == WIN_END) ? 0 : -1;
+    pthread_mutex_unlock(&ts->lock);
+    return n;
+}
+
+/*
+ * trace_stream_rewind - go back to the first request
+ */
+int trace_stream_rewind(tracestream_t *ts)
+{
+    stop(ts);
+    return start(ts);
+}
+
+double trace_stream_stall(tracestream_t *ts)
+{
+    return ts->stall;
+}
+
+void trace_stream_close(tracestream_t *ts)
+{
+    if (ts == NULL)
+	return;
+    stop(ts);
+    if (ts->rd.fp != NULL)
+	fclose(ts->rd.fp);
+    free(ts->win[0]);
+    free(ts->win[1]);
+    free(ts->rd.zbuf);
+    pthread_mutex_destroy(&ts->lock);
+    pthread_cond_destroy(&ts->cond);
+    free(ts);
+}
@@ -0,0 +1,90 @@
+/*
+ * trace.h - malloc lab trace files
+ *
+ * A trace comes in three forms. The text form (.rep) is described in
+ * traces/README. The binary form is a tracehdr_t followed by num_ops
+ * traceop_t records, in native byte order, exactly as the driver uses
+ * them: trace_load() maps it and hands out the records in place,
+ * without parsing. The compressed form is a tracehdr_t followed by
+ * blocks of up to TRACE_WINDOW records, each a traceblk_t and the
+ * lz.c encoding of its records, with the index fields stored as
+ * differences from the previous record's. rep2bin converts text to
+ * either of the others, and trace_load() tells them apart by the magic
+ * at the start.
+ *
+ * A binary or compressed trace can also be streamed: a trace_stream
+ * thread decodes it window by window, one window ahead of the reader,
+ * so that only two windows of requests are ever in memory.
+ */
+#ifndef __TRACE_H_
+#define __TRACE_H_
+
+#include <stddef.h>
+
+#define TRACE_MAGIC    "MMTRBIN1"  /* first 8 bytes of a binary trace */
+#define TRACE_LZ_MAGIC "MMTRLZ01"  /* ... and of a compressed one */
+#define TRACE_WINDOW   65536       /* requests per streamed window */
+
+/* Request types. The values are part of the binary format. */
+enum {ALLOC, FREE, REALLOC, RELEASE, ALLOC_BATCH, FREE_BATCH, CALLOC};
+
+/* Characterizes a single trace operation (allocator request) */
+typedef struct {
+    int type;       /* type of request */
+    int index;      /* index for free() to use later */
+    int size;       /* byte size of alloc/realloc/calloc request */
+    union {
+	int count;  /* number of blocks in a batch op */
+	int align;  /* payload alignment of an alloc, 0 for the default */
+	int nmemb;  /* elements in a calloc of size bytes */
+    };
+} traceop_t;
+
+/* The trace header; the text form has the first four fields only */
+typedef struct {
+    char magic[8];       /* TRACE_MAGIC */
+    int op_size;         /* sizeof(traceop_t) */
+    int sugg_heapsize;   /* suggested heap size (unused) */
+    int num_ids;         /* number of alloc/realloc ids */
+    int num_ops;         /* number of distinct requests */
+    int weight;          /* weight for this trace (unused) */
+    int num_reqs;        /* number of block requests (batches count each) */
+} tracehdr_t;
+
+/* The header of each block of a compressed trace */
+typedef struct {
+    int num_ops;         /* requests in the block */
+    int comp_len;        /* bytes of lz.c data that follow */
+} traceblk_t;
+
+/* A loaded trace */
+typedef struct {
+    tracehdr_t hdr;
+    traceop_t *ops;      /* hdr.num_ops requests */
+    void *map;           /* mapping of a binary trace, or NULL... */
+    size_t map_len;      /* ...if ops was malloc'd and decoded */
+} tracefile_t;
+
+/* A streamed trace */
+typedef struct tracestream tracestream_t;
+
+/* Each returns -1 (or NULL) after printing an error message */
+extern int trace_load(const char *path, tracefile_t *tf);
+extern int trace_save_rep(const char *path, const tracefile_t *tf);
+extern int trace_save_bin(const char *path, const tracefile_t *tf);
+extern int trace_save_lz(const char *path, const tracefile_t *tf);
+extern void trace_unload(tracefile_t *tf);
+
+/*
+ * trace_stream_next() points ops at the next window and returns its
+ * length, or 0 at the end of the trace. The window stays valid until
+ * the next call. trace_stream_stall() is the time spent waiting for
+ * windows that weren't decoded yet, in seconds.
+ */
+extern tracestream_t *trace_stream_open(const char *path, tracehdr_t *hdr);
+extern int trace_stream_next(tracestream_t *ts, traceop_t **ops);
+extern int trace_stream_rewind(tracestream_t *ts);
+extern double trace_stream_stall(tracestream_t *ts);
+extern void trace_stream_close(tracestream_t *ts);
+
+#endif /* __TRACE_H_ */
@@ -0,0 +1,242 @@
+/*
+ * tracemix.c - interleave several traces into one, as if their
+ *     programs shared a heap
+ *
+ * mdriver replays each trace on a fresh heap, so it never sees one
+ * workload's blocks fragment another's free lists. tracemix merges
+ * the requests of N traces into one trace, adding to each trace's ids
+ * the number of ids of the traces before it, and replaying the result
+ * shows the cross-workload effects in util and throughput:
+ *
+ *     unix> tracemix mix.rep traces/cccp-bal.rep traces/expr-bal.rep
+ *     unix> mdriver -V -f mix.rep
+ *
+ * Mixing modes (-m):
+ *     rr       round robin: -q requests from each trace in turn
+ *     random   -q requests at a time from a trace picked at random,
+ *              with probability proportional to its -w weight, or to
+ *              its length so that all traces end about together
+ *     phase    trace i joins the round robin once i * -p requests
+ *              have been mixed, so the traces' phases (build-up,
+ *              steady state, teardown) overlap at different points
+ *
+ * Within each trace the requests keep their order. The end-of-scope
+ * requests (x) are dropped: a scope ends when its own blocks are dead,
+ * not the other traces'. The input may be in any of the three forms;
+ * the output is text, binary with -b, or compressed with -z.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/* Mixing modes */
+enum {MIX_RR, MIX_RANDOM, MIX_PHASE};
+
+/* One input trace */
+typedef struct {
+    const char *path;
+    tracefile_t tf;
+    int next;                /* next request to mix */
+    int id_base;             /* added to each of its ids */
+    double weight;           /* for MIX_RANDOM */
+} input_t;
+
+static unsigned long long rng;
+
+/*
+ * rnd - the next 64 random bits (splitmix64, as in traces/gentrace.c)
+ */
+static unsigned long long rnd(void)
+{
+    unsigned long long z = (rng += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * take - move up to n requests of in to the end of out; returns how
+ *     many requests of in were used
+ */
+static int take(input_t *in, tracefile_t *out, int n)
+{
+    traceop_t *op;
+    int used;
+
+    for (used = 0; used < n && in->next < in->tf.hdr.num_ops; used++) {
+	op = &out->ops[out->hdr.num_ops];
+	*op = in->tf.ops[in->next++];
+	if (op->type == RELEASE)
+	    continue;
+	op->index += in->id_base;
+	out->hdr.num_ops++;
+    }
+    return used;
+}
+
+/*
+ * pick - a trace that has requests left, with probability in
+ *     proportion to its weight
+ */
+static int pick(input_t *in, int n)
+{
+    double total = 0, x;
+    int i, last = -1;
+
+    for (i = 0; i < n; i++)
+	if (in[i].next < in[i].tf.hdr.num_ops)
+	    total += in[i].weight;
+    x = (rnd() >> 11) * (1.0 / 9007199254740992.0) * total;
+    for (i = 0; i < n; i++) {
+	if (in[i].next < in[i].tf.hdr.num_ops) {
+	    last = i;
+	    if ((x -= in[i].weight) < 0)
+		break;
+	}
+    }
+    return i < n ? i : last;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: tracemix [-hbz] [-m <mode>] [-q <n>] [-w <w1,w2,...>] [-p <n>]\n"
+	    "                [-S <seed>] <out> <in>...\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h           Print this message.\n");
+    fprintf(stderr, "\t-b           Write a binary trace.\n");
+    fprintf(stderr, "\t-z           Write a compressed trace.\n");
+    fprintf(stderr, "\t-m <mode>    rr, random or phase (default rr).\n");
+    fprintf(stderr, "\t-q <n>       Requests taken from a trace at a time (default 1).\n");
+    fprintf(stderr, "\t-w <w,...>   Weights of the traces for -m random.\n");
+    fprintf(stderr, "\t-p <n>       Requests between trace starts for -m phase\n"
+	    "\t             (default: the mixed length over twice the traces).\n");
+    fprintf(stderr, "\t-S <seed>    Random seed for -m random (default 1).\n");
+}
+
+int main(int argc, char **argv)
+{
+    input_t *in;
+    tracefile_t out;
+    char *weights = NULL, *w;
+    long total = 0, shift = -1, mixed;
+    int mode = MIX_RR, quantum = 1, format = 0;
+    int n, i, c, active, dropped = 0;
+
+    rng = 1;
+    while ((c = getopt(argc, argv, "hbzm:q:w:p:S:")) != EOF) {
+	switch (c) {
+	case 'b':
+	case 'z':
+	    format = c;
+	    break;
+	case 'm':
+	    if (!strcmp(optarg, "rr"))
+		mode = MIX_RR;
+	    else if (!strcmp(optarg, "random"))
+		mode = MIX_RANDOM;
+	    else if (!strcmp(optarg, "phase"))
+		mode = MIX_PHASE;
+	    else {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'q':
+	    quantum = atoi(optarg);
+	    break;
+	case 'w':
+	    weights = optarg;
+	    break;
+	case 'p':
+	    shift = atol(optarg);
+	    break;
+	case 'S':
+	    rng = strtoull(optarg, NULL, 0);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (argc - optind < 2 || quantum < 1) {
+	usage();
+	exit(1);
+    }
+
+    /* Load the inputs and give each its own range of ids */
+    n = argc - optind - 1;
+    in = calloc(n, sizeof(input_t));
+    memset(&out, 0, sizeof(out));
+    out.hdr.weight = 1;
+    for (i = 0; i < n; i++) {
+	in[i].path = argv[optind + 1 + i];
+	if (trace_load(in[i].path, &in[i].tf) < 0)
+	    exit(1);
+	in[i].id_base = out.hdr.num_ids;
+	in[i].weight = in[i].tf.hdr.num_ops;
+	out.hdr.num_ids += in[i].tf.hdr.num_ids;
+	out.hdr.num_reqs += in[i].tf.hdr.num_reqs;
+	out.hdr.sugg_heapsize += in[i].tf.hdr.sugg_heapsize;
+	total += in[i].tf.hdr.num_ops;
+    }
+    for (w = weights, i = 0; w != NULL && i < n; i++) {
+	if ((in[i].weight = strtod(w, &w)) < 0 || (*w != ',' && *w != '\0')) {
+	    fprintf(stderr, "tracemix: bad weights %s\n", weights);
+	    exit(1);
+	}
+	w = (*w == ',') ? w + 1 : NULL;
+    }
+    if (weights != NULL && (i < n || w != NULL)) {
+	fprintf(stderr, "tracemix: need %d weights\n", n);
+	exit(1);
+    }
+    if (total > 0x7fffffff) {
+	fprintf(stderr, "tracemix: more than 2^31 requests\n");
+	exit(1);
+    }
+    if ((out.ops = malloc((total + 1) * sizeof(traceop_t))) == NULL) {
+	fprintf(stderr, "tracemix: out of memory\n");
+	exit(1);
+    }
+    if (shift < 0)
+	shift = total / (2 * n);
+
+    /* Mix; active is how many traces have joined (all but in phase
+       mode), and mixed counts the input requests used so far */
+    active = (mode == MIX_PHASE) ? 1 : n;
+    for (mixed = 0, i = -1; mixed < total; ) {
+	if (mode == MIX_RANDOM)
+	    i = pick(in, n);
+	else {
+	    while (active < n && (mixed >= active * shift ||
+		   in[active - 1].next == in[active - 1].tf.hdr.num_ops))
+		active++;
+	    i = (i + 1) % active;
+	}
+	mixed += take(&in[i], &out, quantum);
+    }
+    dropped = total - out.hdr.num_ops;
+    out.hdr.num_reqs -= dropped;
+
+    if (format == 'b')
+	c = trace_save_bin(argv[optind], &out);
+    else if (format == 'z')
+	c = trace_save_lz(argv[optind], &out);
+    else
+	c = trace_save_rep(argv[optind], &out);
+    if (c < 0)
+	exit(1);
+    printf("%s: %d requests, %d ids from %d traces", argv[optind],
+	   out.hdr.num_ops, out.hdr.num_ids, n);
+    if (dropped > 0)
+	printf(", %d scope ends dropped", dropped);
+    printf("\n");
+    exit(0);
+}
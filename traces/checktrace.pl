@@ -71,7 +71,7 @@ while ($line = <STDIN>) {
     chomp($line);
     $linenum++;
 
-    ($cmd, $id, $size) = split(" ", $line);
+    ($cmd, $id, $size, $count) = split(" ", $line);
 
     # ignore blank lines
     if (!$cmd) {
@@ -81,6 +81,41 @@ while ($line = <STDIN>) {
     # save the line for output later
     $lines[$requestnum++] = $line;
 
+    # aligned and zeroed allocates are checked like any other allocate
+    if ($cmd eq "m" or $cmd eq "c") {
+	$cmd = "a";
+	$size = $count;
+    }
+
+    # end of a request scope: every block allocated in it must be dead
+    if ($cmd eq "x") {
+	if (%HASH) {
+	    die "$0: ERROR[$linenum]: live blocks at end of request scope\n";
+	}
+	next;
+    }
+
+    # batch ops allocate or free a range of consecutive ids
+    if ($cmd eq "A") {
+	for ($i = $id; $i < $id + $count; $i++) {
+	    if (exists($HASH{$i})) {
+		die "$0: ERROR[$linenum]: batch allocate of live or reused ID $i.\n";
+	    }
+	    $HASH{$i} = "a";
+	}
+	next;
+    }
+    if ($cmd eq "F") {
+	# the count is the second field
+	for ($i = $id; $i < $id + $size; $i++) {
+	    if (!exists($HASH{$i})) {
+		die "$0: ERROR[$linenum]: batch freeing unallocated block $i.\n";
+	    }
+	    delete $HASH{$i};
+	}
+	next;
+    }
+
     #ignore realloc requests, as long as they are preceeded by an alloc request
     if ($cmd eq "r") {
 	if (!$HASH{$id}) {
@@ -0,0 +1,72 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# Message-processing workload built from batch ops. Each message
+# allocates arrays of same-sized objects with "A <id> <bytes> <n>"
+# and frees them with "F <id> <n>", a few messages later and out of
+# order, with single allocations for headers mixed in. Replay it with
+# "mdriver -b" to compare against one-at-a-time malloc/free.
+#
+
+$out_filename = "batch.rep";
+$num_msgs = 2000;
+$max_batches = 3;
+$max_count = 48;
+@obj_sizes = (16, 24, 40, 64, 100);
+$window = 6;
+
+srand(15213);
+
+# Create trace
+$blk = 0;
+$total_block_size = 0;
+@pending = ();
+for ($msg = 0;  $msg < $num_msgs; $msg += 1) {
+    # Message header
+    $hdr = $blk++;
+    $size = 32 + int(rand(200));
+    push @trace, "a $hdr $size";
+    push @pending, "f $hdr";
+    $total_block_size += $size;
+
+    # Arrays of message records
+    $batches = 1 + int(rand($max_batches));
+    for ($i = 0;  $i < $batches; $i += 1) {
+	$count = 1 + int(rand($max_count));
+	$size = $obj_sizes[int(rand(@obj_sizes))];
+	push @trace, "A $blk $size $count";
+	push @pending, "F $blk $count";
+	$blk += $count;
+	$total_block_size += $size * $count;
+    }
+
+    # Retire an older message's data once enough are in flight
+    while (@pending > $window * 3) {
+	$pos = int(rand(@pending / 2));
+	push @trace, $pending[$pos];
+	splice @pending, $pos, 1;
+    }
+}
+while (@pending) {
+    push @trace, shift @pending;
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $total_block_size + 100;
+$num_blocks = $blk;
+$num_ops = @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
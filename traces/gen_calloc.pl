@@ -0,0 +1,88 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# Zeroed allocation workload. Small zeroed records ("c <id> <n> <bytes>")
+# and plain mallocs are freed at random, while a few hash tables are
+# rebuilt at twice the size with calloc and the old table freed, so
+# large callocs land both on fresh heap and on reused free blocks.
+#
+
+$out_filename = "calloc.rep";
+$num_rounds = 4000;
+$max_live = 300;
+$num_tables = 3;
+$min_buckets = 256;
+$max_buckets = 65536;
+
+srand(15213);
+
+# Create trace
+$blk = 0;
+$total_block_size = 0;
+@live = ();
+for ($t = 0;  $t < $num_tables; $t += 1) {
+    $buckets[$t] = $min_buckets;
+    $table[$t] = $blk;
+    push @trace, "c $blk $buckets[$t] 4";
+    $total_block_size += $buckets[$t] * 4;
+    $blk++;
+}
+for ($round = 0;  $round < $num_rounds; $round += 1) {
+    if (rand() < 0.5) {
+	$n = 1 + int(rand(32));
+	$size = (4, 8, 16)[int(rand(3))];
+	push @trace, "c $blk $n $size";
+	$total_block_size += $n * $size;
+    }
+    else {
+	$size = 1 + int(rand(200));
+	push @trace, "a $blk $size";
+	$total_block_size += $size;
+    }
+    push @live, $blk++;
+
+    # Rebuild a hash table now and then: grow it, or start over
+    if (rand() < 0.01) {
+	$t = int(rand($num_tables));
+	push @trace, "f $table[$t]";
+	$buckets[$t] *= 2;
+	$buckets[$t] = $min_buckets if ($buckets[$t] > $max_buckets);
+	$table[$t] = $blk;
+	push @trace, "c $blk $buckets[$t] 4";
+	$total_block_size += $buckets[$t] * 4;
+	$blk++;
+    }
+
+    # Free random records once enough are in flight
+    while (@live > $max_live || (@live > $max_live / 4 && rand() < 0.5)) {
+	$pos = int(rand(@live));
+	push @trace, "f $live[$pos]";
+	splice @live, $pos, 1;
+    }
+}
+while (@live) {
+    push @trace, "f " . shift @live;
+}
+for ($t = 0;  $t < $num_tables; $t += 1) {
+    push @trace, "f $table[$t]";
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $total_block_size + 100;
+$num_blocks = $blk;
+$num_ops = @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
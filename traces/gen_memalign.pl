@@ -0,0 +1,71 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# Aligned allocation workload. Ordinary mallocs are mixed with
+# "m <id> <align> <bytes>" requests for cache-line aligned objects,
+# page-aligned I/O buffers and 16/32-byte aligned vectors, and live
+# blocks are freed at random so the gaps in front of aligned blocks
+# get reused.
+#
+
+$out_filename = "memalign.rep";
+$num_allocs = 3000;
+$max_live = 200;
+
+srand(15213);
+
+# Create trace
+$total_block_size = 0;
+@live = ();
+for ($blk = 0;  $blk < $num_allocs; $blk += 1) {
+    $kind = int(rand(10));
+    if ($kind < 4) {
+	$size = 1 + int(rand(300));
+	push @trace, "a $blk $size";
+    }
+    elsif ($kind < 7) {
+	$size = 64 * (1 + int(rand(4)));
+	push @trace, "m $blk 64 $size";
+    }
+    elsif ($kind < 9) {
+	$align = (16, 32)[int(rand(2))];
+	$size = $align * (1 + int(rand(16)));
+	push @trace, "m $blk $align $size";
+    }
+    else {
+	$size = 512 * (1 + int(rand(8)));
+	push @trace, "m $blk 4096 $size";
+    }
+    push @live, $blk;
+    $total_block_size += $size;
+
+    # Free a random live block once enough are in flight
+    while (@live > $max_live || (@live > $max_live / 4 && rand() < 0.5)) {
+	$pos = int(rand(@live));
+	push @trace, "f $live[$pos]";
+	splice @live, $pos, 1;
+    }
+}
+while (@live) {
+    push @trace, "f " . shift @live;
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $total_block_size + 100;
+$num_blocks = $num_allocs;
+$num_ops = @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
@@ -0,0 +1,83 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+#
+# Request-scoped workload: each request allocates a batch of small
+# objects plus a response buffer that grows by realloc, frees them in
+# random order, and ends with an "x" (end of request scope) line.
+# Nothing outlives its request, so a region allocator can drop all
+# of the request's frees and release everything at the "x".
+#
+
+$out_filename = "request.rep";
+$num_requests = 600;
+$min_objs = 8;
+$max_objs = 40;
+$max_obj_size = 256;
+$buf_size = 64;
+$buf_increment = 96;
+$max_grows = 6;
+
+srand(15213);
+
+# Create trace
+$blk = 0;
+$total_block_size = 0;
+for ($req = 0;  $req < $num_requests; $req += 1) {
+    @live = ();
+
+    # Response buffer, grown by realloc as the request is processed
+    $buf = $blk++;
+    $size = $buf_size;
+    push @trace, "a $buf $size";
+    $grows = int(rand($max_grows + 1));
+
+    $num_objs = $min_objs + int(rand($max_objs - $min_objs + 1));
+    for ($i = 0;  $i < $num_objs; $i += 1) {
+	$osize = 8 + int(rand($max_obj_size - 8));
+	push @trace, "a $blk $osize";
+	push @live, $blk++;
+	$total_block_size += $osize;
+
+	# Free some objects while the request is still running
+	if (@live > 4 && rand() < 0.3) {
+	    $pos = int(rand(@live));
+	    push @trace, "f $live[$pos]";
+	    splice @live, $pos, 1;
+	}
+	if ($grows > 0 && rand() < 0.2) {
+	    $size += $buf_increment;
+	    push @trace, "r $buf $size";
+	    $grows -= 1;
+	}
+    }
+    $total_block_size += $size;
+
+    # Request done: everything dies, in random order
+    push @live, $buf;
+    while (@live) {
+	$pos = int(rand(@live));
+	push @trace, "f $live[$pos]";
+	splice @live, $pos, 1;
+    }
+    push @trace, "x";
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $total_block_size + 100;
+$num_blocks = $blk;
+$num_ops = @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
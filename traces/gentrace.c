@@ -0,0 +1,510 @@
+/*
+ * gentrace.c - generate large synthetic traces
+ *
+ * Unlike the perl generators, which place each free with a linear
+ * search and a splice, gentrace simulates the program: each step
+ * allocates one block, perhaps reallocates a live one, and frees the
+ * blocks whose lifetime is up. It runs in O(n log n) and emits
+ * millions of requests in seconds.
+ *
+ *     unix> ./gentrace -n 1000000 -s power:16:65536:1.5 -l exp:2000 big
+ *
+ * writes big.rep, in which long-lived blocks are never freed, and
+ * big-bal.rep, the balanced form that checktrace.pl would produce.
+ * The same options and seed always give the same traces.
+ *
+ * Size distributions (-s):
+ *     uniform:MIN:MAX        every size in [MIN, MAX] equally likely
+ *     power:MIN:MAX:ALPHA    P(size) ~ size^-ALPHA on [MIN, MAX]
+ *     bimodal:S1:S2:P        near S1 (within 25%) with probability P,
+ *                            else near S2
+ *     hist:FILE              an empirical histogram, "size weight" lines
+ *
+ * Lifetimes (-l), counted in allocation steps:
+ *     exp:MEAN               exponentially distributed
+ *     lifo:DEPTH             stack order: after each step the newest
+ *                            blocks are freed down to a random depth
+ *                            in [0, DEPTH]
+ *     fifo:DEPTH             queue order: each block lives DEPTH steps
+ * and -L FRAC makes that fraction of blocks live to the end.
+ *
+ * Realloc growth (-g), for the fraction -r of steps that reallocate a
+ * random live block:
+ *     geom:FACTOR            size times FACTOR, as a growing vector
+ *     linear:INC             size plus INC, as a growing buffer
+ *     dist                   a new size from the size distribution
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define MAXLINE  1024
+#define DEF_OPS  100000       /* default allocation steps */
+#define DEF_MAX  (1 << 20)    /* default size cap */
+
+/* Size distributions */
+enum {SZ_UNIFORM, SZ_POWER, SZ_BIMODAL, SZ_HIST};
+
+/* Lifetime models */
+enum {LT_EXP, LT_LIFO, LT_FIFO};
+
+/* Realloc growth models */
+enum {RG_GEOM, RG_LINEAR, RG_DIST};
+
+/* A block waiting for its death step, in the exp model's heap */
+typedef struct {
+    long death;
+    int id;
+} death_t;
+
+/* The whole configuration and simulation state */
+typedef struct {
+    /* options */
+    long steps;
+    unsigned long seed;
+    int max_size;
+    int sz_kind;
+    double sz_a, sz_b, sz_c;
+    int hist_n;
+    int *hist_size;
+    double *hist_cum;        /* cumulative weights */
+    int lt_kind;
+    double lt_param;
+    double long_frac;
+    double realloc_frac;
+    int rg_kind;
+    double rg_param;
+
+    /* simulation */
+    unsigned long rng;
+    int *size;               /* current size of each id */
+    int *live;               /* live ids, in no order... */
+    int *live_pos;           /* ...and the position of each id there */
+    int nlive;
+    int *order;              /* lifo stack or fifo ring of ids */
+    long order_head, order_tail;
+    death_t *heap;           /* exp deaths, a binary min-heap */
+    int nheap;
+    long live_bytes, peak_bytes;
+    int ids;                 /* ids handed out */
+    long ops;                /* requests emitted */
+    FILE *out, *bal;
+} gen_t;
+
+/*
+ * rnd - the next 64 random bits (splitmix64: small, fast, and the
+ *     same on every platform, unlike rand())
+ */
+static unsigned long long rnd(gen_t *g)
+{
+    unsigned long long z = (g->rng += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* A uniform double in [0, 1) */
+static double unif(gen_t *g)
+{
+    return (rnd(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int clamp_size(gen_t *g, double s)
+{
+    if (s < 1)
+	return 1;
+    if (s > g->max_size)
+	return g->max_size;
+    return (int)s;
+}
+
+/*
+ * draw_size - a size from the size distribution
+ */
+static int draw_size(gen_t *g)
+{
+    double u = unif(g), a = g->sz_a, b = g->sz_b, c = g->sz_c, e;
+    int lo, hi, mid;
+
+    switch (g->sz_kind) {
+    case SZ_UNIFORM:
+	return clamp_size(g, a + u * (b - a + 1));
+    case SZ_POWER:
+	if (fabs(c - 1) < 1e-9)
+	    return clamp_size(g, a * pow(b / a, u));
+	e = 1 - c;
+	return clamp_size(g, pow(pow(a, e) + u * (pow(b, e) - pow(a, e)),
+				 1 / e));
+    case SZ_BIMODAL:
+	a = (u < c) ? a : b;
+	return clamp_size(g, a * (0.75 + 0.5 * unif(g)));
+    default:
+	u *= g->hist_cum[g->hist_n - 1];
+	for (lo = 0, hi = g->hist_n - 1; lo < hi; ) {
+	    mid = (lo + hi) / 2;
+	    if (g->hist_cum[mid] > u)
+		hi = mid;
+	    else
+		lo = mid + 1;
+	}
+	return clamp_size(g, g->hist_size[lo]);
+    }
+}
+
+/*
+ * Request output: every request goes to both traces
+ */
+static void emit(gen_t *g, const char *fmt, int a, int b)
+{
+    if (g->out != NULL) {
+	fprintf(g->out, fmt, a, b);
+	fprintf(g->bal, fmt, a, b);
+    }
+    g->ops++;
+}
+
+static void do_alloc(gen_t *g, int id, int size)
+{
+    g->size[id] = size;
+    g->live_pos[id] = g->nlive;
+    g->live[g->nlive++] = id;
+    g->live_bytes += size;
+    if (g->live_bytes > g->peak_bytes)
+	g->peak_bytes = g->live_bytes;
+    emit(g, "a %d %d\n", id, size);
+}
+
+static void do_free(gen_t *g, int id)
+{
+    int pos = g->live_pos[id], last = g->live[--g->nlive];
+
+    g->live[pos] = last;
+    g->live_pos[last] = pos;
+    g->live_pos[id] = -1;
+    g->live_bytes -= g->size[id];
+    emit(g, "f %d\n", id, 0);
+}
+
+/*
+ * do_realloc - resize a random live block by the growth model
+ */
+static void do_realloc(gen_t *g)
+{
+    int id = g->live[rnd(g) % g->nlive];
+    double size = g->size[id];
+
+    switch (g->rg_kind) {
+    case RG_GEOM:
+	size *= g->rg_param;
+	break;
+    case RG_LINEAR:
+	size += g->rg_param;
+	break;
+    default:
+	size = draw_size(g);
+	break;
+    }
+    g->live_bytes += clamp_size(g, size) - g->size[id];
+    if (g->live_bytes > g->peak_bytes)
+	g->peak_bytes = g->live_bytes;
+    g->size[id] = clamp_size(g, size);
+    emit(g, "r %d %d\n", id, g->size[id]);
+}
+
+/*
+ * Binary min-heap of death steps, for the exp model
+ */
+static void heap_push(gen_t *g, long death, int id)
+{
+    int i = g->nheap++, parent;
+
+    while (i > 0 && g->heap[parent = (i - 1) / 2].death > death) {
+	g->heap[i] = g->heap[parent];
+	i = parent;
+    }
+    g->heap[i].death = death;
+    g->heap[i].id = id;
+}
+
+static int heap_pop(gen_t *g)
+{
+    int id = g->heap[0].id, i = 0, child;
+    death_t last = g->heap[--g->nheap];
+
+    while ((child = 2 * i + 1) < g->nheap) {
+	if (child + 1 < g->nheap &&
+	    g->heap[child + 1].death < g->heap[child].death)
+	    child++;
+	if (g->heap[child].death >= last.death)
+	    break;
+	g->heap[i] = g->heap[child];
+	i = child;
+    }
+    g->heap[i] = last;
+    return id;
+}
+
+/*
+ * simulate - run the whole simulation, writing the traces if g->out
+ *     is set, or just counting ids and requests if not
+ */
+static void simulate(gen_t *g)
+{
+    long t, target;
+    int id;
+
+    g->rng = g->seed;
+    g->nlive = g->nheap = 0;
+    g->order_head = g->order_tail = 0;
+    g->live_bytes = g->peak_bytes = 0;
+    g->ids = 0;
+    g->ops = 0;
+
+    for (t = 0; t < g->steps; t++) {
+	if (g->nlive > 0 && unif(g) < g->realloc_frac)
+	    do_realloc(g);
+
+	id = g->ids++;
+	do_alloc(g, id, draw_size(g));
+	if (unif(g) < g->long_frac)
+	    continue;  /* lives to the end */
+
+	switch (g->lt_kind) {
+	case LT_EXP:
+	    heap_push(g, t + (long)ceil(-g->lt_param * log(1 - unif(g))), id);
+	    while (g->nheap > 0 && g->heap[0].death <= t)
+		do_free(g, heap_pop(g));
+	    break;
+	case LT_LIFO:
+	    g->order[g->order_tail++] = id;
+	    target = rnd(g) % ((long)g->lt_param + 1);
+	    while (g->order_tail > target)
+		do_free(g, g->order[--g->order_tail]);
+	    break;
+	case LT_FIFO:
+	    g->order[g->order_tail++ % g->steps] = id;
+	    while (g->order_tail - g->order_head > (long)g->lt_param)
+		do_free(g, g->order[g->order_head++ % g->steps]);
+	    break;
+	}
+    }
+}
+
+/*
+ * read_hist - read an empirical size histogram of "size weight" lines
+ */
+static void read_hist(gen_t *g, const char *path)
+{
+    FILE *fp;
+    int size, cap = 64;
+    double weight, sum = 0;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+	fprintf(stderr, "gentrace: can't open %s\n", path);
+	exit(1);
+    }
+    g->hist_size = malloc(cap * sizeof(int));
+    g->hist_cum = malloc(cap * sizeof(double));
+    while (fscanf(fp, "%d %lf", &size, &weight) == 2) {
+	if (size <= 0 || weight < 0) {
+	    fprintf(stderr, "gentrace: bad histogram line in %s\n", path);
+	    exit(1);
+	}
+	if (g->hist_n == cap) {
+	    cap *= 2;
+	    g->hist_size = realloc(g->hist_size, cap * sizeof(int));
+	    g->hist_cum = realloc(g->hist_cum, cap * sizeof(double));
+	}
+	sum += weight;
+	g->hist_size[g->hist_n] = size;
+	g->hist_cum[g->hist_n++] = sum;
+    }
+    fclose(fp);
+    if (g->hist_n == 0 || sum <= 0) {
+	fprintf(stderr, "gentrace: empty histogram %s\n", path);
+	exit(1);
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: gentrace [-h] [-n <steps>] [-S <seed>] [-s <sizes>] [-M <max>]\n"
+	    "                [-l <lifetimes>] [-L <frac>] [-r <frac>] [-g <growth>] <name>\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h             Print this message.\n");
+    fprintf(stderr, "\t-n <steps>     Allocations to make (default %d).\n", DEF_OPS);
+    fprintf(stderr, "\t-S <seed>      Random seed (default 1).\n");
+    fprintf(stderr, "\t-s <sizes>     uniform:MIN:MAX, power:MIN:MAX:ALPHA, bimodal:S1:S2:P\n"
+	    "\t               or hist:FILE (default power:8:4096:1.2).\n");
+    fprintf(stderr, "\t-M <max>       Largest size, after growth too (default %d).\n", DEF_MAX);
+    fprintf(stderr, "\t-l <lifetimes> exp:MEAN, lifo:DEPTH or fifo:DEPTH (default exp:1000).\n");
+    fprintf(stderr, "\t-L <frac>      Fraction of blocks that are never freed (default 0).\n");
+    fprintf(stderr, "\t-r <frac>      Fraction of steps that realloc a block (default 0).\n");
+    fprintf(stderr, "\t-g <growth>    geom:FACTOR, linear:INC or dist (default geom:2).\n");
+    fprintf(stderr, "Writes <name>.rep and the balanced <name>-bal.rep.\n");
+}
+
+/*
+ * parse_spec - split "kind:x:y:z" into kind and up to three numbers;
+ *     returns how many numbers there were
+ */
+static int parse_spec(char *spec, char **kind, double *x, double *y,
+		      double *z)
+{
+    char *rest = strchr(spec, ':');
+    int n = 0;
+
+    *kind = spec;
+    if (rest != NULL) {
+	*rest++ = '\0';
+	n = sscanf(rest, "%lf:%lf:%lf", x, y, z);
+    }
+    return n;
+}
+
+static void bad_option(const char *what)
+{
+    fprintf(stderr, "gentrace: bad %s\n", what);
+    usage();
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    gen_t g;
+    char path[MAXLINE];
+    char *kind;
+    double x, y, z;
+    int c, n;
+
+    memset(&g, 0, sizeof(g));
+    g.steps = DEF_OPS;
+    g.seed = 1;
+    g.max_size = DEF_MAX;
+    g.sz_kind = SZ_POWER;
+    g.sz_a = 8;
+    g.sz_b = 4096;
+    g.sz_c = 1.2;
+    g.lt_kind = LT_EXP;
+    g.lt_param = 1000;
+    g.rg_kind = RG_GEOM;
+    g.rg_param = 2;
+
+    while ((c = getopt(argc, argv, "hn:S:s:M:l:L:r:g:")) != EOF) {
+	switch (c) {
+	case 'n':
+	    g.steps = atol(optarg);
+	    break;
+	case 'S':
+	    g.seed = strtoul(optarg, NULL, 0);
+	    break;
+	case 'M':
+	    g.max_size = atoi(optarg);
+	    break;
+	case 's':
+	    if (!strncmp(optarg, "hist:", 5) && optarg[5] != '\0') {
+		g.sz_kind = SZ_HIST;
+		read_hist(&g, optarg + 5);
+		break;
+	    }
+	    n = parse_spec(optarg, &kind, &x, &y, &z);
+	    if (!strcmp(kind, "uniform") && n == 2 && x >= 1 && y >= x)
+		g.sz_kind = SZ_UNIFORM;
+	    else if (!strcmp(kind, "power") && n == 3 && x >= 1 && y >= x)
+		g.sz_kind = SZ_POWER;
+	    else if (!strcmp(kind, "bimodal") && n == 3 && x >= 1 && y >= 1 &&
+		     z >= 0 && z <= 1)
+		g.sz_kind = SZ_BIMODAL;
+	    else
+		bad_option("size distribution");
+	    g.sz_a = x;
+	    g.sz_b = y;
+	    g.sz_c = z;
+	    break;
+	case 'l':
+	    n = parse_spec(optarg, &kind, &x, &y, &z);
+	    if (n != 1 || x < 0)
+		bad_option("lifetime model");
+	    if (!strcmp(kind, "exp"))
+		g.lt_kind = LT_EXP;
+	    else if (!strcmp(kind, "lifo"))
+		g.lt_kind = LT_LIFO;
+	    else if (!strcmp(kind, "fifo"))
+		g.lt_kind = LT_FIFO;
+	    else
+		bad_option("lifetime model");
+	    g.lt_param = x;
+	    break;
+	case 'L':
+	    g.long_frac = atof(optarg);
+	    break;
+	case 'r':
+	    g.realloc_frac = atof(optarg);
+	    break;
+	case 'g':
+	    n = parse_spec(optarg, &kind, &x, &y, &z);
+	    if (!strcmp(kind, "geom") && n == 1 && x > 0)
+		g.rg_kind = RG_GEOM;
+	    else if (!strcmp(kind, "linear") && n == 1)
+		g.rg_kind = RG_LINEAR;
+	    else if (!strcmp(kind, "dist") && n == 0)
+		g.rg_kind = RG_DIST;
+	    else
+		bad_option("realloc growth model");
+	    g.rg_param = x;
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (argc - optind != 1 || g.steps <= 0 || g.steps > 0x7fffffff ||
+	g.max_size <= 0) {
+	usage();
+	exit(1);
+    }
+
+    if ((g.size = malloc(g.steps * sizeof(int))) == NULL ||
+	(g.live = malloc(g.steps * sizeof(int))) == NULL ||
+	(g.live_pos = malloc(g.steps * sizeof(int))) == NULL ||
+	(g.order = malloc(g.steps * sizeof(int))) == NULL ||
+	(g.heap = malloc(g.steps * sizeof(death_t))) == NULL) {
+	fprintf(stderr, "gentrace: out of memory\n");
+	exit(1);
+    }
+
+    /* A counting run for the headers, then the same run for real */
+    simulate(&g);
+    sprintf(path, "%s.rep", argv[optind]);
+    if ((g.out = fopen(path, "w")) == NULL) {
+	fprintf(stderr, "gentrace: can't create %s\n", path);
+	exit(1);
+    }
+    sprintf(path, "%s-bal.rep", argv[optind]);
+    if ((g.bal = fopen(path, "w")) == NULL) {
+	fprintf(stderr, "gentrace: can't create %s\n", path);
+	exit(1);
+    }
+    fprintf(g.out, "%ld\n%d\n%ld\n1\n", g.peak_bytes, g.ids, g.ops);
+    fprintf(g.bal, "%ld\n%d\n%ld\n1\n", g.peak_bytes, g.ids,
+	    g.ops + g.nlive);
+    simulate(&g);
+
+    /* Balance the trace, in id order as checktrace.pl does */
+    for (n = 0; n < g.ids; n++)
+	if (g.live_pos[n] >= 0)
+	    fprintf(g.bal, "f %d\n", n);
+    if (fclose(g.out) != 0 || fclose(g.bal) != 0) {
+	fprintf(stderr, "gentrace: write error\n");
+	exit(1);
+    }
+    printf("%s: %d ids, %ld requests, %d never freed, peak %ld bytes\n",
+	   argv[optind], g.ids, g.ops, g.nlive, g.peak_bytes);
+    exit(0);
+}
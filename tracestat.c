@@ -0,0 +1,510 @@
+/*
+ * tracestat.c - profile the workload in malloc lab traces
+ *
+ * For each trace, tracestat checks consistency as checktrace.pl does
+ * (and with -s does only that), and reports
+ *
+ *     - the histogram of request sizes, in power-of-two buckets,
+ *     - the histogram of block lifetimes, in requests from the
+ *       allocate to the free,
+ *     - the live bytes over the trace: the peak in each of -p equal
+ *       slices of the requests,
+ *     - the realloc chains: how many times each block was resized,
+ *       and by what ratio each time,
+ *     - the order of the frees: of the newest live block (LIFO), of
+ *       the oldest (FIFO), or of some other block.
+ *
+ *         unix> tracestat traces/cccp-bal.rep
+ *         unix> tracestat -c traces/cccp-bal.rep traces/expr-bal.rep > p.csv
+ *
+ * Each request costs a few array lookups, and binary and compressed
+ * traces are streamed rather than loaded, so a trace of 100M requests
+ * takes seconds once it is converted with rep2bin. Text traces are
+ * loaded whole and parsed first.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+#define NBUCKETS   32   /* power-of-two buckets, up to 2^31 */
+#define DEF_POINTS 20   /* default slices of the live-bytes curve */
+
+/* Growth ratio buckets: shrinks, no change, and growths */
+#define NGROWTH 8
+static const double growth_lo[NGROWTH] = {0, 0.5, 1, 1, 1.25, 1.5, 2, 4};
+static const double growth_hi[NGROWTH] = {0.5, 1, 1, 1.25, 1.5, 2, 4, 0};
+
+/* Block states */
+enum {NEVER, LIVE, DEAD};
+
+/* The profile of one trace, and the state to build it */
+typedef struct {
+    const char *path;
+    tracehdr_t hdr;
+    long req;                  /* requests seen, batches counting each */
+    long op;                   /* operations seen */
+    long nalloc, nfree, nrealloc, nrelease;
+
+    /* per id */
+    char *state;
+    int *size;
+    int *born;                 /* request of the allocate */
+    int *chain;                /* reallocs so far */
+
+    /* free order: newest live block on top of the stack, oldest at
+       the head of the queue; dead ids are skipped lazily */
+    int *stack, top;
+    int *queue, head, tail;
+    long lifo, fifo, other;
+
+    long size_hist[NBUCKETS];
+    long life_hist[NBUCKETS];
+    long chain_hist[NBUCKETS];
+    long growth_hist[NGROWTH];
+    long nlive;
+
+    /* live bytes */
+    long live_bytes, peak_bytes, peak_req;
+    int points;
+    long *slice_peak;          /* peak live bytes in each slice */
+    long *slice_blocks;        /* live blocks at that peak */
+} stat_t;
+
+static int csv = 0;
+static int summary = 0;
+
+/* bucket - the power-of-two bucket of v: 0 for 0 and 1, k for
+   [2^k, 2^(k+1)) */
+static int bucket(long v)
+{
+    int k = 0;
+
+    while (v > 1 && k < NBUCKETS - 1) {
+	v >>= 1;
+	k++;
+    }
+    return k;
+}
+
+/*
+ * fail - report an inconsistent trace, as checktrace.pl would
+ */
+static int fail(stat_t *st, const char *msg, int id)
+{
+    if (id < 0)
+	fprintf(stderr, "tracestat: %s: request %ld: %s\n", st->path,
+		st->op, msg);
+    else
+	fprintf(stderr, "tracestat: %s: request %ld: %s (id %d)\n",
+		st->path, st->op, msg, id);
+    return -1;
+}
+
+static void note_live(stat_t *st)
+{
+    int s = st->req * st->points / (st->hdr.num_reqs > 0 ?
+				     st->hdr.num_reqs : 1);
+
+    if (s >= st->points)
+	s = st->points - 1;
+    if (st->live_bytes > st->slice_peak[s]) {
+	st->slice_peak[s] = st->live_bytes;
+	st->slice_blocks[s] = st->nlive;
+    }
+    if (st->live_bytes > st->peak_bytes) {
+	st->peak_bytes = st->live_bytes;
+	st->peak_req = st->req;
+    }
+}
+
+static int do_alloc(stat_t *st, int id, int size)
+{
+    if (id < 0 || id >= st->hdr.num_ids)
+	return fail(st, "id out of range", id);
+    if (st->state[id] == LIVE)
+	return fail(st, "allocate with no intervening free", id);
+    if (st->state[id] == DEAD)
+	return fail(st, "reused ID", id);
+    st->state[id] = LIVE;
+    st->size[id] = size;
+    st->born[id] = st->req;
+    st->stack[st->top++] = id;
+    st->queue[st->tail++] = id;
+    st->size_hist[bucket(size)]++;
+    st->nalloc++;
+    st->nlive++;
+    st->live_bytes += size;
+    note_live(st);
+    st->req++;
+    return 0;
+}
+
+static int do_realloc(stat_t *st, int id, int size)
+{
+    int old, k;
+
+    if (id < 0 || id >= st->hdr.num_ids || st->state[id] != LIVE)
+	return fail(st, "realloc without previous alloc", id);
+    old = st->size[id];
+    if (old == 0 || size > 4.0 * old)
+	k = NGROWTH - 1;
+    else if (size == old)
+	k = 2;
+    else
+	for (k = 0; k < NGROWTH - 1; k++)
+	    if (k != 2 && size < growth_hi[k] * old)
+		break;
+    st->growth_hist[k]++;
+    st->chain[id]++;
+    st->size[id] = size;
+    st->nrealloc++;
+    st->live_bytes += size - old;
+    note_live(st);
+    st->req++;
+    return 0;
+}
+
+static int do_free(stat_t *st, int id)
+{
+    if (id < 0 || id >= st->hdr.num_ids || st->state[id] == NEVER)
+	return fail(st, "freeing unallocated block", id);
+    if (st->state[id] == DEAD)
+	return fail(st, "freeing already freed block", id);
+
+    while (st->state[st->stack[st->top - 1]] != LIVE)
+	st->top--;
+    while (st->state[st->queue[st->head]] != LIVE)
+	st->head++;
+    if (st->stack[st->top - 1] == id)
+	st->lifo++;
+    else if (st->queue[st->head] == id)
+	st->fifo++;
+    else
+	st->other++;
+
+    st->state[id] = DEAD;
+    st->life_hist[bucket(st->req - st->born[id])]++;
+    if (st->chain[id] > 0)
+	st->chain_hist[bucket(st->chain[id])]++;
+    st->nfree++;
+    st->nlive--;
+    st->live_bytes -= st->size[id];
+    note_live(st);
+    st->req++;
+    return 0;
+}
+
+/*
+ * step - account for one request
+ */
+static int step(stat_t *st, const traceop_t *op)
+{
+    int i;
+
+    switch (op->type) {
+    case ALLOC:
+    case CALLOC:
+	if (do_alloc(st, op->index, op->size) < 0)
+	    return -1;
+	break;
+    case ALLOC_BATCH:
+	for (i = 0; i < op->count; i++)
+	    if (do_alloc(st, op->index + i, op->size) < 0)
+		return -1;
+	break;
+    case REALLOC:
+	if (do_realloc(st, op->index, op->size) < 0)
+	    return -1;
+	break;
+    case FREE:
+	if (do_free(st, op->index) < 0)
+	    return -1;
+	break;
+    case FREE_BATCH:
+	for (i = 0; i < op->count; i++)
+	    if (do_free(st, op->index + i) < 0)
+		return -1;
+	break;
+    case RELEASE:
+	if (st->nlive > 0)
+	    return fail(st, "live blocks at end of request scope", -1);
+	st->nrelease++;
+	break;
+    default:
+	return fail(st, "bogus request type", op->type);
+    }
+    st->op++;
+    return 0;
+}
+
+/*
+ * print_hist - print a power-of-two histogram, skipping the empty
+ *     buckets at either end
+ */
+static void print_hist(stat_t *st, const char *metric, const char *title,
+		       const long *hist)
+{
+    long total = 0, cum = 0;
+    int lo, hi, k;
+
+    for (lo = 0; lo < NBUCKETS && hist[lo] == 0; lo++)
+	;
+    for (hi = NBUCKETS - 1; hi >= lo && hist[hi] == 0; hi--)
+	;
+    for (k = lo; k <= hi; k++)
+	total += hist[k];
+
+    if (!csv && total > 0)
+	printf("\n%-28s %10s %6s %6s\n", title, "count", "%", "cum%");
+    for (k = lo; k <= hi; k++) {
+	cum += hist[k];
+	if (csv)
+	    printf("%s,%s,%ld,%ld,%ld\n", st->path, metric,
+		   k ? 1L << k : 0, (2L << k) - 1, hist[k]);
+	else
+	    printf("  %12ld - %-12ld %10ld %6.1f %6.1f\n", k ? 1L << k : 0,
+		   (2L << k) - 1, hist[k], 100.0 * hist[k] / total,
+		   100.0 * cum / total);
+    }
+}
+
+/*
+ * report - print the profile of a consistent trace
+ */
+static void report(stat_t *st)
+{
+    long nfreed = st->lifo + st->fifo + st->other;
+    long nchains = 0, from, to;
+    int k;
+
+    if (summary) {
+	if (st->nlive > 0)
+	    printf("%s: Unbalanced trace.\n", st->path);
+	else
+	    printf("%s: Balanced trace.\n", st->path);
+	return;
+    }
+
+    for (k = 0; k < st->hdr.num_ids; k++)
+	if (st->state[k] == LIVE && st->chain[k] > 0)
+	    st->chain_hist[bucket(st->chain[k])]++;
+    for (k = 0; k < NBUCKETS; k++)
+	nchains += st->chain_hist[k];
+
+    if (csv) {
+	printf("%s,requests,,,%ld\n", st->path, st->req);
+	printf("%s,allocs,,,%ld\n", st->path, st->nalloc);
+	printf("%s,frees,,,%ld\n", st->path, st->nfree);
+	printf("%s,reallocs,,,%ld\n", st->path, st->nrealloc);
+	printf("%s,never_freed,,,%ld\n", st->path, st->nlive);
+	printf("%s,peak_bytes,,,%ld\n", st->path, st->peak_bytes);
+	printf("%s,peak_request,,,%ld\n", st->path, st->peak_req);
+	printf("%s,free_lifo,,,%ld\n", st->path, st->lifo);
+	printf("%s,free_fifo,,,%ld\n", st->path, st->fifo);
+	printf("%s,free_other,,,%ld\n", st->path, st->other);
+    } else {
+	printf("%s: %ld requests: %ld allocs, %ld frees, %ld reallocs, "
+	       "%ld scope ends\n", st->path, st->req, st->nalloc,
+	       st->nfree, st->nrealloc, st->nrelease);
+	if (st->nlive > 0)
+	    printf("Unbalanced: %ld blocks (%ld bytes) never freed\n",
+		   st->nlive, st->live_bytes);
+	else
+	    printf("Balanced trace.\n");
+    }
+
+    print_hist(st, "size", "Request sizes (bytes)", st->size_hist);
+    print_hist(st, "lifetime", "Lifetimes (requests)", st->life_hist);
+
+    if (!csv)
+	printf("\nLive bytes: peak %ld at request %ld\n"
+	       "%-28s %10s %10s\n", st->peak_bytes, st->peak_req,
+	       "  requests", "peak", "blocks");
+    for (k = 0; k < st->points; k++) {
+	from = (long)k * st->hdr.num_reqs / st->points;
+	to = (long)(k + 1) * st->hdr.num_reqs / st->points - 1;
+	if (csv)
+	    printf("%s,live_bytes,%ld,%ld,%ld\n", st->path, from, to,
+		   st->slice_peak[k]);
+	else
+	    printf("  %12ld - %-12ld %10ld %10ld\n", from, to,
+		   st->slice_peak[k], st->slice_blocks[k]);
+    }
+
+    if (st->nrealloc > 0) {
+	if (!csv)
+	    printf("\nRealloc chains: %ld blocks resized, %.2f times each "
+		   "on average\n", nchains, (double)st->nrealloc / nchains);
+	print_hist(st, "realloc_chain", "Chain lengths (reallocs)",
+		   st->chain_hist);
+	if (!csv)
+	    printf("\n%-28s %10s %6s\n", "Growth ratios (new/old)",
+		   "count", "%");
+	for (k = 0; k < NGROWTH; k++) {
+	    if (csv)
+		printf("%s,growth,%g,%g,%ld\n", st->path, growth_lo[k],
+		       growth_hi[k], st->growth_hist[k]);
+	    else if (k == 2)
+		printf("  %12s   %-12s %10ld %6.1f\n", "1", "(same size)",
+		       st->growth_hist[k],
+		       100.0 * st->growth_hist[k] / st->nrealloc);
+	    else if (k == NGROWTH - 1)
+		printf("  %12g - %-12s %10ld %6.1f\n", growth_lo[k], "up",
+		       st->growth_hist[k],
+		       100.0 * st->growth_hist[k] / st->nrealloc);
+	    else
+		printf("  %12g - %-12g %10ld %6.1f\n", growth_lo[k],
+		       growth_hi[k], st->growth_hist[k],
+		       100.0 * st->growth_hist[k] / st->nrealloc);
+	}
+    }
+
+    if (!csv && nfreed > 0)
+	printf("\nFree order: %.1f%% LIFO (newest live block), "
+	       "%.1f%% FIFO (oldest), %.1f%% other\n",
+	       100.0 * st->lifo / nfreed, 100.0 * st->fifo / nfreed,
+	       100.0 * st->other / nfreed);
+}
+
+/*
+ * is_binary - does the trace at path have a binary or compressed
+ *     header, so that it can be streamed?
+ */
+static int is_binary(const char *path)
+{
+    char magic[sizeof(((tracehdr_t *)0)->magic)];
+    FILE *fp;
+    int rc = 0;
+
+    if ((fp = fopen(path, "r")) == NULL)
+	return 0;  /* trace_load() reports it */
+    if (fread(magic, sizeof(magic), 1, fp) == 1)
+	rc = !memcmp(magic, TRACE_MAGIC, sizeof(magic)) ||
+	    !memcmp(magic, TRACE_LZ_MAGIC, sizeof(magic));
+    fclose(fp);
+    return rc;
+}
+
+/*
+ * stat_trace - profile the trace at path; returns -1 if it can't be
+ *     read or isn't consistent
+ */
+static int stat_trace(const char *path, int points)
+{
+    stat_t st;
+    tracefile_t tf;
+    tracestream_t *ts = NULL;
+    traceop_t *ops;
+    long n, i;
+    int rc = -1;
+
+    memset(&st, 0, sizeof(st));
+    st.path = path;
+    st.points = points;
+    if (is_binary(path)) {
+	if ((ts = trace_stream_open(path, &st.hdr)) == NULL)
+	    return -1;
+    } else {
+	if (trace_load(path, &tf) < 0)
+	    return -1;
+	st.hdr = tf.hdr;
+    }
+
+    n = st.hdr.num_ids > 0 ? st.hdr.num_ids : 1;
+    if ((st.state = calloc(n, sizeof(char))) == NULL ||
+	(st.size = malloc(n * sizeof(int))) == NULL ||
+	(st.born = malloc(n * sizeof(int))) == NULL ||
+	(st.chain = calloc(n, sizeof(int))) == NULL ||
+	(st.stack = malloc(n * sizeof(int))) == NULL ||
+	(st.queue = malloc(n * sizeof(int))) == NULL ||
+	(st.slice_peak = calloc(points, sizeof(long))) == NULL ||
+	(st.slice_blocks = calloc(points, sizeof(long))) == NULL) {
+	fprintf(stderr, "tracestat: out of memory for %s\n", path);
+	goto out;
+    }
+
+    if (ts != NULL) {
+	while ((n = trace_stream_next(ts, &ops)) > 0)
+	    for (i = 0; i < n; i++)
+		if (step(&st, &ops[i]) < 0)
+		    goto out;
+	if (n < 0)
+	    goto out;
+    } else
+	for (i = 0; i < st.hdr.num_ops; i++)
+	    if (step(&st, &tf.ops[i]) < 0)
+		goto out;
+
+    report(&st);
+    rc = 0;
+
+ out:
+    if (ts != NULL)
+	trace_stream_close(ts);
+    else
+	trace_unload(&tf);
+    free(st.state);
+    free(st.size);
+    free(st.born);
+    free(st.chain);
+    free(st.stack);
+    free(st.queue);
+    free(st.slice_peak);
+    free(st.slice_blocks);
+    return rc;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: tracestat [-hcs] [-p <points>] <trace>...\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h           Print this message.\n");
+    fprintf(stderr, "\t-c           Print CSV: trace,metric,lo,hi,value.\n");
+    fprintf(stderr, "\t-s           Only check each trace, as checktrace.pl -s.\n");
+    fprintf(stderr, "\t-p <points>  Slices of the live-bytes curve (default %d).\n",
+	    DEF_POINTS);
+}
+
+int main(int argc, char **argv)
+{
+    int points = DEF_POINTS;
+    int status = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "hcsp:")) != EOF) {
+	switch (c) {
+	case 'c':
+	    csv = 1;
+	    break;
+	case 's':
+	    summary = 1;
+	    break;
+	case 'p':
+	    points = atoi(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (optind == argc || points < 1) {
+	usage();
+	exit(1);
+    }
+
+    if (csv && !summary)
+	printf("trace,metric,lo,hi,value\n");
+    for (; optind < argc; optind++) {
+	if (stat_trace(argv[optind], points) < 0)
+	    status = 1;
+	else if (!csv && !summary && optind < argc - 1)
+	    printf("\n");
+    }
+    exit(status);
+}